@@ -0,0 +1,388 @@
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <memory>
+
+#include "core/types.h"
+#include "core/log.h"
+#include "core/file.h"
+
+#include "meta.h"
+#include "cr_constants.h"
+#include "cr_globals.h"
+#include "generate.h"
+#include "parse/parse.h"
+#include "cr_util.h"
+
+using namespace cr;
+using std::vector;
+
+/**
+ * Shape of the synthetic schema to benchmark against
+ */
+struct BenchConfig {
+
+	i32 _classes;
+	i32 _fields; // per class
+	i32 _depth; // length of the object:Foo chains (0 means no object fields)
+	i32 _files; // input files the classes are spread over
+	i32 _runs;
+	i32 _warmup; // runs that are done but not counted
+	bool _schemaCache; // load inputs from the schema cache (after the first run) instead of parsing them
+	vector<string> _types; // field types, used round robin
+	string _workDir;
+};
+
+/**
+ * Timings (in nanoseconds) collected over the counted runs for one phase
+ */
+struct PhaseSamples {
+
+	const char* _name;
+	vector<ui64> _samples;
+};
+
+void printUsage();
+i32 parseCL( i32 argc, char** argv, BenchConfig& config );
+void makeDir( const string& path );
+list<File> writeSchemas( const BenchConfig& config );
+void printPhase( const PhaseSamples& phase );
+
+// main
+i32 main( i32 argc, char** argv ) {
+
+	try {
+
+		BenchConfig config;
+		i32 error = parseCL( argc, argv, config );
+		if ( error ) {
+
+			// print usage case
+			if (  error == -1 ) {
+				return 0;
+			}
+
+			return error;
+		}
+
+		list<File> inputs = writeSchemas( config );
+
+		string outputPath = config._workDir + "/out";
+		makeDir( outputPath );
+		File outputDir( outputPath );
+		if ( config._schemaCache ) {
+			g_schemaCacheDir = File( outputDir, CR_SCHEMA_CACHE_DIR_NAME "/" );
+		}
+
+		// the generators log every class; only the numbers are interesting here
+		Log::setMinLogLevel( LOG_LEVEL_WARN );
+
+		PhaseSamples parsePhase = { "parse", {} };
+		PhaseSamples generatePhase = { "generate", {} };
+		PhaseSamples outputPhase = { "file output", {} };
+		PhaseSamples totalPhase = { "total", {} };
+
+		typedef std::chrono::high_resolution_clock Clock;
+
+		vector<string> outputs;
+		for ( i32 run = 0; run < config._warmup + config._runs; run++ ) {
+
+			// start from an empty output dir so that every run generates and writes every file
+			for ( const string& output : outputs ) {
+				File( output ).rm();
+			}
+			outputs.clear();
+
+			File fingerprintFile( outputDir, CR_FINGERPRINT_FILE_NAME );
+			if ( fingerprintFile.exists() ) {
+				fingerprintFile.rm();
+			}
+
+			auto start = Clock::now();
+
+			vector<shared_ptr<GenConfig>> configs = parseAll( inputs, g_jobs );
+
+			auto parsed = Clock::now();
+
+			for ( shared_ptr<GenConfig>& genConfig : configs ) {
+				genConfig->_outputDir = outputDir;
+				for ( const Class& c : genConfig->_package._classes ) {
+					invalidateAll( c._name );
+				}
+			}
+
+			GenStats stats;
+			generateAll( configs, stats );
+
+			auto generated = Clock::now();
+
+			// generation and output are interleaved per class, so split the class time up
+			ui64 writeNanos = 0;
+			ui64 classNanos = 0;
+			for ( const ClassGenStats& classStats : stats._classes ) {
+				writeNanos += classStats._writeTimeNanos;
+				classNanos += classStats._genTimeNanos;
+				for ( const OutputFileStats& output : classStats._outputs ) {
+					outputs.push_back( output._path );
+				}
+			}
+
+			if ( run < config._warmup ) {
+				continue;
+			}
+
+			parsePhase._samples.push_back( std::chrono::duration_cast<std::chrono::nanoseconds>( parsed - start ).count() );
+			generatePhase._samples.push_back( classNanos - writeNanos );
+			outputPhase._samples.push_back( writeNanos );
+			totalPhase._samples.push_back( std::chrono::duration_cast<std::chrono::nanoseconds>( generated - start ).count() );
+		}
+
+		std::cout << "--- Benchmark ---" << std::endl;
+		std::cout << config._classes << " classes x " << config._fields << " fields, object depth " << config._depth
+				<< ", " << config._files << " input files, " << g_jobs << " jobs, "
+				<< config._runs << " runs (" << config._warmup << " warmup)"
+				<< (config._schemaCache ? ", schema cache" : "") << std::endl;
+		std::cout << "phase          median(ms)   mean(ms)  stddev(ms)    min(ms)    max(ms)" << std::endl;
+		printPhase( parsePhase );
+		printPhase( generatePhase );
+		printPhase( outputPhase );
+		printPhase( totalPhase );
+		if ( g_jobs > 1 ) {
+			std::cout << "(generate and file output are summed over all jobs; total is wall time)" << std::endl;
+		}
+
+		return 0;
+
+	} catch ( const exception& e ) {
+		Log::i( "std::exception caught in main: %s", e.what() );
+		return 1;
+	} catch ( ... ) {
+		Log::i( "unrecognized exception caught in main" );
+		return 1;
+	}
+}
+
+/**
+ * Parse a positive (or, if allowZero, non-negative) integer option value
+ */
+static i32 parseCount( i32& i, i32 argc, char** argv, bool allowZero = false ) {
+
+	if ( i + 1 >= argc ) {
+		throw CRException( "Missing value for %s", argv[i] );
+	}
+
+	const char* value = argv[++i];
+	char* end = nullptr;
+	long count = strtol( value, &end, 10 );
+	if ( end == value || *end != 0x00 || count < (allowZero ? 0 : 1) ) {
+		throw CRException( "Invalid value for %s: %s", argv[i - 1], value );
+	}
+
+	return (i32)count;
+}
+
+// parseCL
+i32 parseCL( i32 argc, char** argv, BenchConfig& config ) {
+
+	// --help -h --usage
+	if ( argc == 2
+			&& ((strcmp( argv[1], "--help" ) == 0)
+			|| (strcmp( argv[1], "-h" ) == 0)
+			|| (strcmp( argv[1], "--usage" ) == 0))) {
+		printUsage();
+		return -1;
+	}
+
+	config._classes = 1000;
+	config._fields = 10;
+	config._depth = 3;
+	config._files = 1;
+	config._runs = 10;
+	config._warmup = 1;
+	config._schemaCache = false;
+	config._types = { "i8", "ui8", "i16", "ui16", "i32", "ui32", "i64", "ui64", "f32", "f64", "bool", "string" };
+
+	// a single job by default; parallel timings are much noisier
+	g_jobs = 1;
+	g_deterministic = true;
+
+	std::vector<const char*> positional;
+	for ( i32 i = 1; i < argc; i++ ) {
+
+		if ( strcmp( argv[i], "--classes" ) == 0 ) {
+			config._classes = parseCount( i, argc, argv );
+
+		} else if ( strcmp( argv[i], "--fields" ) == 0 ) {
+			config._fields = parseCount( i, argc, argv );
+
+		} else if ( strcmp( argv[i], "--depth" ) == 0 ) {
+			config._depth = parseCount( i, argc, argv, true );
+
+		} else if ( strcmp( argv[i], "--files" ) == 0 ) {
+			config._files = parseCount( i, argc, argv );
+
+		} else if ( strcmp( argv[i], "--runs" ) == 0 ) {
+			config._runs = parseCount( i, argc, argv );
+
+		} else if ( strcmp( argv[i], "--warmup" ) == 0 ) {
+			config._warmup = parseCount( i, argc, argv, true );
+
+		} else if ( strcmp( argv[i], "--schema-cache" ) == 0 ) {
+			config._schemaCache = true;
+
+		} else if ( strcmp( argv[i], "-j" ) == 0 ) {
+			g_jobs = parseCount( i, argc, argv );
+
+		} else if ( strcmp( argv[i], "--types" ) == 0 ) {
+			if ( i + 1 >= argc ) {
+				throw CRException( "Missing value for %s", argv[i] );
+			}
+
+			// comma separated; validate each one now rather than in the middle of a run
+			config._types.clear();
+			std::stringstream types( argv[++i] );
+			string type;
+			while ( std::getline( types, type, ',' )) {
+				if ( toDataType( type ) == DataType::OBJECT ) {
+					throw CRException( "Object fields are controlled by --depth, not --types" );
+				}
+				config._types.push_back( type );
+			}
+			if ( config._types.empty() ) {
+				throw CRException( "No types given for --types" );
+			}
+
+		} else {
+			positional.push_back( argv[i] );
+		}
+	}
+
+	if ( positional.size() != 1 ) {
+		printUsage();
+		return 1;
+	}
+
+	config._workDir = positional[0];
+	config._files = std::min( config._files, config._classes );
+
+	return 0;
+}
+
+// makeDir
+void makeDir( const string& path ) {
+	if ( ::mkdir( path.c_str(), 0755 ) != 0 && errno != EEXIST ) {
+		throw CRException( "Failed to create directory %s: %s", path.c_str(), strerror( errno ));
+	}
+}
+
+// writeSchemas
+list<File> writeSchemas( const BenchConfig& config ) {
+
+	makeDir( config._workDir );
+	string schemaDir = config._workDir + "/schema";
+	makeDir( schemaDir );
+
+	list<File> inputs;
+	i32 classesPerFile = (config._classes + config._files - 1) / config._files;
+
+	for ( i32 file = 0; file < config._files; file++ ) {
+
+		std::stringstream xml;
+		xml << "<CodeRoller languages=\"CPP\" defaultMemberPrivacy=\"private\" defaultSerializable=\"true\">" << std::endl;
+
+		i32 end = std::min( config._classes, (file + 1) * classesPerFile );
+		for ( i32 c = file * classesPerFile; c < end; c++ ) {
+
+			xml << "\t<class name=\"Bench" << c << "\">" << std::endl;
+
+			// classes form chains of config._depth + 1, each holding the previous one as its last field
+			bool holdsObject = (config._depth > 0) && (c % (config._depth + 1) != 0);
+
+			for ( i32 f = 0; f < config._fields; f++ ) {
+				xml << "\t\t<field name=\"field" << f << "\" type=\"";
+				if ( holdsObject && f == config._fields - 1 ) {
+					xml << "object:Bench" << (c - 1);
+				} else {
+					xml << config._types[(c + f) % config._types.size()];
+				}
+				xml << "\" />" << std::endl;
+			}
+
+			xml << "\t</class>" << std::endl;
+		}
+
+		xml << "</CodeRoller>" << std::endl;
+
+		char fileName[64];
+		snprintf( fileName, sizeof( fileName ), "/bench%d.cr.xml", file );
+
+		File input( schemaDir + fileName );
+		input.writeIfChanged( xml.str() );
+		inputs.push_back( File( input.getFullPath() ));
+	}
+
+	return inputs;
+}
+
+// printPhase
+void printPhase( const PhaseSamples& phase ) {
+
+	vector<ui64> sorted = phase._samples;
+	std::sort( sorted.begin(), sorted.end() );
+
+	size_t count = sorted.size();
+	double median = (count % 2 == 1)
+			? (double)sorted[count / 2]
+			: ((double)sorted[count / 2 - 1] + (double)sorted[count / 2]) / 2.0;
+
+	double mean = 0.0;
+	for ( ui64 sample : sorted ) {
+		mean += (double)sample;
+	}
+	mean /= (double)count;
+
+	// sample variance
+	double variance = 0.0;
+	for ( ui64 sample : sorted ) {
+		variance += ((double)sample - mean) * ((double)sample - mean);
+	}
+	variance = (count > 1) ? variance / (double)(count - 1) : 0.0;
+
+	char line[256];
+	snprintf( line, sizeof( line ), "%-12s %11.3f %10.3f %11.3f %10.3f %10.3f",
+			phase._name,
+			median / 1000000.0,
+			mean / 1000000.0,
+			sqrt( variance ) / 1000000.0,
+			(double)sorted.front() / 1000000.0,
+			(double)sorted.back() / 1000000.0 );
+	std::cout << line << std::endl;
+}
+
+// printUsage
+void printUsage() {
+
+	Log::i( "coderoller generator benchmark" );
+	Log::i( "  version %d.%d", CR_MAJOR_VERSION, CR_MINOR_VERSION );
+	Log::i( "  usage: coderoller_bench [options] [work dir]" );
+	Log::i( "  Synthesizes a schema under [work dir]/schema and repeatedly generates it into [work dir]/out," );
+	Log::i( "  reporting the median, mean, standard deviation, min and max time of each phase." );
+	Log::i( "  options:" );
+	Log::i( "    --classes N       number of classes (default: 1000)" );
+	Log::i( "    --fields N        fields per class (default: 10)" );
+	Log::i( "    --types T,T,...   field types to cycle through (default: every primitive type and string)" );
+	Log::i( "    --depth N         length of object:Class chains; 0 for no object fields (default: 3)" );
+	Log::i( "    --files N         number of input files to spread the classes over (default: 1)" );
+	Log::i( "    --runs N          number of measured runs (default: 10)" );
+	Log::i( "    --warmup N        number of unmeasured runs first (default: 1)" );
+	Log::i( "    --schema-cache    use the schema cache, so runs after the first measure loading it" );
+	Log::i( "    -j N              worker threads for parsing and generation (default: 1)" );
+}
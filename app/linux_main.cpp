@@ -1,6 +1,10 @@
 #include <string.h>
+#include <stdlib.h>
 #include <chrono>
 #include <iostream>
+#include <vector>
+#include <memory>
+#include <set>
 
 #include "core/types.h"
 #include "core/log.h"
@@ -9,14 +13,19 @@
 #include "meta.h"
 #include "cr_constants.h"
 #include "cr_globals.h"
+#include "depfile.h"
 #include "generate.h"
 #include "parse/parse.h"
+#include "stats_report.h"
+#include "watch.h"
 #include "cr_util.h"
 
 using namespace cr;
+using std::vector;
 
 void printUsage();
 i32 parseCL( i32 argc, char** argv );
+void printStats( ui64 parseTimeNanos, ui64 genTimeNanos, size_t inputFiles, const GenStats& genStats );
 
 // main
 i32 main( i32 argc, char** argv ) {
@@ -34,43 +43,102 @@ i32 main( i32 argc, char** argv ) {
 			return error;
 		}
 
+		// keep stdout clean for the stats report
+		if ( g_statsFormat != StatsFormat::NONE && ! g_statsFile.isValid() ) {
+			Log::setMinLogLevel( LOG_LEVEL_WARN );
+		}
+
 		typedef std::chrono::high_resolution_clock Clock;
 		auto start = Clock::now();
 
 		// parse XML
-		shared_ptr<GenConfig> config = parseXML( argv[1] );
+		vector<shared_ptr<GenConfig>> configs = parseAll( g_inputFiles, g_jobs );
 
 		auto now = Clock::now();
 		std::chrono::nanoseconds parseTime = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start);
 		start = now;
 
-		config->_outputDir = g_outputDir;
+		for ( shared_ptr<GenConfig>& config : configs ) {
+			config->_outputDir = g_outputDir;
+		}
 
 		// generate code
-		generateAll( config );
+		GenStats genStats;
+		generateAll( configs, genStats );
+
+		if ( g_depfile.isValid() ) {
+			writeDepfile( g_depfile, genStats );
+		}
+		if ( g_outputManifest.isValid() ) {
+			writeOutputManifest( g_outputManifest, genStats );
+		}
 
 		now = Clock::now();
 		std::chrono::nanoseconds genTime = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start);
 
-		double parseTimeSec = (double)parseTime.count() / 1000000000.0;
-		double genTimeSec = (double)genTime.count() / 1000000000.0;
+		if ( g_statsFormat != StatsFormat::NONE ) {
+			string report = formatStatsReport( g_statsFormat, parseTime.count(), genTime.count(), configs.size(), genStats );
+			if ( g_statsFile.isValid() ) {
+				g_statsFile.writeIfChanged( report );
+			} else {
+				std::cout << report;
+			}
+		}
 
-		std::cout.precision(8);
-		std::cout << "--- Stats ---" << std::endl;
-		std::cout << "Parse time: " << std::fixed << parseTimeSec << " seconds" << std::endl;
-		std::cout << "Gen time: " << std::fixed << genTimeSec << " seconds" << std::endl;
-		std::cout << "Total time: " << std::fixed << (parseTimeSec + genTimeSec) << " seconds" << std::endl;
+		// the report replaces the human readable stats on stdout
+		if ( g_statsFormat == StatsFormat::NONE || g_statsFile.isValid() ) {
+			printStats( parseTime.count(), genTime.count(), configs.size(), genStats );
+		}
+
+		if ( g_watch ) {
+			watchAndRegenerate( configs, genStats );
+		}
 
 		return 0;
 
 	} catch ( const exception& e ) {
-		Log::i( "std::exception caught in main: %s", e.what() );
+		Log::e( "std::exception caught in main: %s", e.what() );
 		return 1;
 	} catch ( ... ) {
-		Log::i( "unrecognized exception caught in main" );
+		Log::e( "unrecognized exception caught in main" );
 	}
 }
 
+// printStats
+void printStats( ui64 parseTimeNanos, ui64 genTimeNanos, size_t inputFiles, const GenStats& genStats ) {
+
+	// find the most expensive class
+	const ClassGenStats* slowest = nullptr;
+	ui64 classTimeNanos = 0;
+	i32 classesSkipped = 0;
+	i32 filesWritten = 0;
+	for ( const ClassGenStats& classStats : genStats._classes ) {
+		classTimeNanos += classStats._genTimeNanos;
+		classesSkipped += classStats._skipped ? 1 : 0;
+		filesWritten += classStats._filesWritten;
+		if ( slowest == nullptr || classStats._genTimeNanos > slowest->_genTimeNanos ) {
+			slowest = &classStats;
+		}
+	}
+
+	double parseTimeSec = (double)parseTimeNanos / 1000000000.0;
+	double genTimeSec = (double)genTimeNanos / 1000000000.0;
+
+	std::cout.precision(8);
+	std::cout << "--- Stats ---" << std::endl;
+	std::cout << "Parse time: " << std::fixed << parseTimeSec << " seconds"
+			<< " (" << inputFiles << " input files)" << std::endl;
+	std::cout << "Gen time: " << std::fixed << genTimeSec << " seconds"
+			<< " (" << genStats._classes.size() << " classes, " << g_jobs << " jobs)" << std::endl;
+	std::cout << "Classes up to date: " << classesSkipped << ", files written: " << filesWritten << std::endl;
+	std::cout << "Class gen time (sum): " << std::fixed << ((double)classTimeNanos / 1000000000.0) << " seconds" << std::endl;
+	if ( slowest ) {
+		std::cout << "Slowest class: " << slowest->_className << " (" << std::fixed
+				<< ((double)slowest->_genTimeNanos / 1000000000.0) << " seconds)" << std::endl;
+	}
+	std::cout << "Total time: " << std::fixed << (parseTimeSec + genTimeSec) << " seconds" << std::endl;
+}
+
 // parseCL
 i32 parseCL( i32 argc, char** argv ) {
 
@@ -83,28 +151,108 @@ i32 parseCL( i32 argc, char** argv ) {
 		return -1;
 	}
 
-	if ( argc < 3 ) {
+	g_jobs = getCoreCount();
+
+	bool useSchemaCache = true;
+
+	std::vector<const char*> positional;
+	for ( i32 i = 1; i < argc; i++ ) {
+
+		// -j N, -jN
+		if ( strncmp( argv[i], "-j", 2 ) == 0 ) {
+			const char* value = argv[i] + 2;
+			if ( *value == 0x00 ) {
+				if ( i + 1 >= argc ) {
+					throw CRException( "Missing value for -j" );
+				}
+				value = argv[++i];
+			}
+
+			g_jobs = atoi( value );
+			if ( g_jobs < 1 ) {
+				throw CRException( "Invalid job count %s", value );
+			}
+
+		} else if ( strcmp( argv[i], "--deterministic" ) == 0 ) {
+			g_deterministic = true;
+
+		} else if ( strcmp( argv[i], "--watch" ) == 0 ) {
+			g_watch = true;
+
+		} else if ( strcmp( argv[i], "--no-cache" ) == 0 ) {
+			useSchemaCache = false;
+
+		} else if ( strcmp( argv[i], "--depfile" ) == 0 || strcmp( argv[i], "--manifest" ) == 0 ) {
+			if ( i + 1 >= argc ) {
+				throw CRException( "Missing value for %s", argv[i] );
+			}
+			File& file = (strcmp( argv[i], "--depfile" ) == 0) ? g_depfile : g_outputManifest;
+			file = File( argv[++i] );
+
+		} else if ( strncmp( argv[i], "--stats=", 8 ) == 0 ) {
+			g_statsFormat = toStatsFormat( argv[i] + 8 );
+
+		} else if ( strncmp( argv[i], "--unity=", 8 ) == 0 ) {
+			const char* value = argv[i] + 8;
+			if ( strcmp( value, "package" ) == 0 ) {
+				g_unityOutput = UnityOutput::PACKAGE;
+			} else {
+				g_unityOutput = UnityOutput::SHARDS;
+				g_unityShards = atoi( value );
+				if ( g_unityShards < 1 ) {
+					throw CRException( "Invalid unity output %s (expected package or a number of files)", value );
+				}
+			}
+
+		} else if ( strcmp( argv[i], "--stats-file" ) == 0 ) {
+			if ( i + 1 >= argc ) {
+				throw CRException( "Missing value for %s", argv[i] );
+			}
+			g_statsFile = File( argv[++i] );
+
+		} else {
+			positional.push_back( argv[i] );
+		}
+	}
+
+	if ( positional.size() < 2 ) {
 		printUsage();
 		return 1;
 	}
 
-	g_inputFile = File( argv[1] );
-	if ( ! g_inputFile.exists() && ! g_inputFile.isDir() ) {
-		throw CRException( "Invalid input file %s", argv[1] );
+	// everything but the last argument is an input
+	const char* outputPath = positional.back();
+	positional.pop_back();
+
+	for ( const char* inputPath : positional ) {
+		collectInputFiles( inputPath, g_inputFiles );
+	}
+
+	// the same file may be reachable through more than one input; only parse it once
+	std::set<string> seen;
+	g_inputFiles.remove_if( [&seen]( const File& file ) {
+		return ! seen.insert( file.getFullPath() ).second;
+	} );
+	if ( g_inputFiles.empty() ) {
+		throw CRException( "No input files found" );
 	}
 
-	g_outputDir = File( argv[2] );
+	g_outputDir = File( outputPath );
 	if (! g_outputDir.exists()) {
 		// our File class doesn't do too well with non-existent files, esp. when it comes to mkdir
 		// g_outputDir.mkdir(true);
 
 		// ...so just make a system call...
 		char buffer[4096];
-		snprintf(buffer, sizeof(buffer), "mkdir %s", argv[2]);
-		system(buffer); // exec "mkdir <argv[2]>"
+		snprintf(buffer, sizeof(buffer), "mkdir %s", outputPath);
+		system(buffer); // exec "mkdir <outputPath>"
 	}
 	if ( ! g_outputDir.exists() && ! g_outputDir.isDir() ) {
-		throw CRException( "Invalid output directory %s", argv[2] );
+		throw CRException( "Invalid output directory %s", outputPath );
+	}
+
+	if ( useSchemaCache ) {
+		g_schemaCacheDir = File( g_outputDir, CR_SCHEMA_CACHE_DIR_NAME "/" );
 	}
 
 	return 0;
@@ -115,5 +263,20 @@ void printUsage() {
 
 	Log::i( "coderoller code generator (c) Stephen Shelton" );
 	Log::i( "  version %d.%d", CR_MAJOR_VERSION, CR_MINOR_VERSION );
-	Log::i( "  usage: coderoller [input file] [output base dir]" );
+	Log::i( "  usage: coderoller [options] [input]... [output base dir]" );
+	Log::i( "  inputs:" );
+	Log::i( "    file.cr.xml       an input file" );
+	Log::i( "    dir               all *.cr.xml files in the directory and its subdirectories" );
+	Log::i( "    @manifest         all inputs listed (one per line) in the manifest file" );
+	Log::i( "  options:" );
+	Log::i( "    -j N              generate classes using N worker threads (default: number of cores)" );
+	Log::i( "    --deterministic   omit timestamps so identical input always produces identical output" );
+	Log::i( "    --watch           keep running, regenerating whenever an input file changes" );
+	Log::i( "    --no-cache        always parse the XML inputs rather than loading them from the schema cache" );
+	Log::i( "    --depfile FILE    write a Make/Ninja depfile listing the generated files and their inputs" );
+	Log::i( "    --manifest FILE   write the list of generated files (\"output<tab>input\" per line)" );
+	Log::i( "    --stats=FORMAT    report timings, file sizes and peak memory as json or csv" );
+	Log::i( "    --stats-file FILE write the --stats report to FILE instead of stdout" );
+	Log::i( "    --unity=package   write one unity source per input file rather than a source per class" );
+	Log::i( "    --unity=N         write N unity sources, with classes spread among them by name" );
 }
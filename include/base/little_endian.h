@@ -0,0 +1,92 @@
+#ifndef __CR_BASE_LITTLE_ENDIAN_H_
+#define __CR_BASE_LITTLE_ENDIAN_H_
+
+#include <stddef.h>
+#include <string.h>
+
+#include "core/types.h"
+
+// whether the host stores multibyte values most significant byte first
+#if defined( __BYTE_ORDER__ ) && defined( __ORDER_BIG_ENDIAN__ ) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define CR_BIG_ENDIAN_HOST 1
+#else
+#define CR_BIG_ENDIAN_HOST 0
+#endif
+
+namespace cr {
+
+/**
+ * The wire format (of generated classes and of StreamRoller streams) stores primitives little endian,
+ * whatever the host. These read and write them through memcpy, so the buffer needn't be aligned. On a
+ * little endian host the byte order is already right and each call compiles down to a plain load or
+ * store; a big endian host swaps the bytes on the way.
+ *
+ * There is no bulk swap of arrays, as nothing writes one: fields aren't repeated, and FooColumns
+ * writes row by row. A Wire struct is swapped member by member (see fromHost()).
+ */
+namespace LittleEndian {
+
+	/**
+	 * The unsigned integer type of the given size, holding a value's bits while they are swapped
+	 */
+	template <size_t SIZE> struct Bits;
+	template <> struct Bits<1> { typedef ui8 Type; static ui8 swap( ui8 bits ) { return bits; } };
+	template <> struct Bits<2> { typedef ui16 Type; static ui16 swap( ui16 bits ) { return __builtin_bswap16( bits ); } };
+	template <> struct Bits<4> { typedef ui32 Type; static ui32 swap( ui32 bits ) { return __builtin_bswap32( bits ); } };
+	template <> struct Bits<8> { typedef ui64 Type; static ui64 swap( ui64 bits ) { return __builtin_bswap64( bits ); } };
+
+	/**
+	 * Returns the given value (an integer, float or bool) with its bytes reversed
+	 */
+	template <typename T>
+	inline T swapBytes( T value ) {
+		typename Bits<sizeof( T )>::Type bits;
+		memcpy( &bits, &value, sizeof( T ));
+		bits = Bits<sizeof( T )>::swap( bits );
+		memcpy( &value, &bits, sizeof( T ));
+		return value;
+	}
+
+	/**
+	 * Convert a host value to its wire (little endian) representation, e.g. for a member of a
+	 * generated Wire struct. Converting back is the same operation. A big endian host swaps
+	 * neighbouring members of a struct in straight line code, which the compiler can vectorize.
+	 */
+	template <typename T>
+	inline T fromHost( T value ) {
+#if CR_BIG_ENDIAN_HOST
+		return swapBytes( value );
+#else
+		return value;
+#endif
+	}
+
+	template <typename T>
+	inline T toHost( T value ) {
+		return fromHost( value );
+	}
+
+	/**
+	 * Write the given value to buffer, returning the number of bytes written
+	 */
+	template <typename T>
+	inline i64 write( void* buffer, T value ) {
+		value = fromHost( value );
+		memcpy( buffer, &value, sizeof( T ));
+		return sizeof( T );
+	}
+
+	/**
+	 * Read a value written by write(), returning the number of bytes read
+	 */
+	template <typename T>
+	inline i64 read( const void* buffer, T* value ) {
+		memcpy( value, buffer, sizeof( T ));
+		*value = toHost( *value );
+		return sizeof( T );
+	}
+}
+
+}
+
+#endif
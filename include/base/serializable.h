@@ -38,6 +38,15 @@ public:
 	 */
 	virtual i64 internalize( void* buffer ) = 0;
 
+	/**
+	 * Internalize the serialized stream like internalize( void* ), but without reading past the
+	 * first bufferSize bytes of it, so that truncated or malicious input is safe to pass.
+	 *
+	 * Should return the number of bytes used, or -1 if the stream doesn't fit in bufferSize bytes (in
+	 * which case some members may already have been internalized). Nothing is thrown.
+	 */
+	virtual i64 internalize( const void* buffer, i64 bufferSize ) = 0;
+
 	/**
 	 * Return a hash code for the class that uniquely identifies it. If the class definition changes 
 	 * such that its serialization semantics change, this hash should also change.
@@ -38,6 +38,8 @@ namespace cr {
  *   - The serialized object
  * - 2 bytes 0x7372 ("sr") to designate the end of the StreamRoller stream
  *
+ * Multibyte values (here, and in the serialized objects) are little endian, and needn't be aligned.
+ *
  *
  * The rest of this file contains utilities to help pull data out of this stream and create a stream.
  *
@@ -53,6 +55,16 @@ namespace cr {
  */
 vector<pair<i32, i64>> listStreamContents( void* pointer );
 
+/**
+ * List the stream contents like listStreamContents( void* ), but without reading past the first size
+ * bytes of the stream, so that truncated or malicious input is safe to pass. The pairs are stored in
+ * contents.
+ *
+ * @return the size of the stream, or -1 if it is invalid, of a different version or doesn't fit in
+ * size bytes. Nothing is thrown.
+ */
+i64 listStreamContents( const void* pointer, i64 size, vector<pair<i32, i64>>& contents );
+
 /** 
  * Create a data stream. This will return a new buffer (inside a unique_ptr) with the contents of the stream.
  *
@@ -66,6 +78,30 @@ pair<i64, unique_ptr<ui8[]>> createStreamContents( const list<const Serializable
  */
 pair<i64, unique_ptr<ui8[]>> createStreamContents( const Serializable& object );
 
+/**
+ * Create a data stream from a batch of objects of the templated TYPE, in the same format. Every call on
+ * the objects is statically dispatched (see serializeObject()).
+ */
+template <typename TYPE>
+pair<i64, unique_ptr<ui8[]>> createStreamContents( const vector<TYPE>& objects );
+
+/**
+ * Statically dispatched equivalents of the Serializable functions, for code which knows the concrete
+ * TYPE. The calls are qualified, so they never go through the vtable (and can be inlined), and they
+ * also work with classes generated with dispatch="static", which don't implement Serializable at all.
+ */
+template <typename TYPE>
+i64 serializeObject( const TYPE& object, void* buffer );
+
+template <typename TYPE>
+i64 getObjectSerializedSize( const TYPE& object );
+
+template <typename TYPE>
+i64 internalizeObject( TYPE& object, void* buffer );
+
+template <typename TYPE>
+i64 internalizeObject( TYPE& object, const void* buffer, i64 bufferSize );
+
 /**
  * Creates an object of the templated TYPE from the given data stream. This is designed to work with 
  * Serializable types that have an empty constructor and an internalize() method.
@@ -80,6 +116,17 @@ TYPE inflate( void* pointer );
 template <typename TYPE>
 TYPE getObject( const vector<pair<i32, i64>>& contents, void* pointer, i64 itemIndex );
 
+/**
+ * Internalize the given object in the given stream of size bytes into object, with its bounds
+ * checked internalize, so that it reads no further than the object's recorded size. The contents
+ * should come from listStreamContents( const void*, i64, ... ).
+ *
+ * @return the number of bytes of the object read, or -1 if the index is out of bounds or the object
+ * doesn't fit in its size. Nothing is thrown.
+ */
+template <typename TYPE>
+i64 getObject( const vector<pair<i32, i64>>& contents, const void* pointer, i64 size, i64 itemIndex, TYPE& object );
+
 }
 
 #include "base/stream_roller.tpp"
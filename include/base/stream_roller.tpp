@@ -8,7 +8,9 @@
 #include "core/types.h"
 #include "core/exception.h"
 
+#include "base/little_endian.h"
 #include "base/serializable.h"
+#include "cr_constants.h"
 
 using std::vector;
 using std::pair;
@@ -16,11 +18,86 @@ using std::unique_ptr;
 
 namespace cr {
 
+// serializeObject
+template <typename TYPE>
+i64 serializeObject( const TYPE& object, void* buffer ) {
+	return object.TYPE::serialize( buffer );
+}
+
+// getObjectSerializedSize
+template <typename TYPE>
+i64 getObjectSerializedSize( const TYPE& object ) {
+	return object.TYPE::getSerializedSize();
+}
+
+// internalizeObject
+template <typename TYPE>
+i64 internalizeObject( TYPE& object, void* buffer ) {
+	return object.TYPE::internalize( buffer );
+}
+
+// internalizeObject
+template <typename TYPE>
+i64 internalizeObject( TYPE& object, const void* buffer, i64 bufferSize ) {
+	return object.TYPE::internalize( buffer, bufferSize );
+}
+
+// createStreamContents
+template <typename TYPE>
+pair<i64, unique_ptr<ui8[]>> createStreamContents( const vector<TYPE>& objects ) {
+
+	// see createStreamContents( const list<const Serializable*> ) for the layout
+	i64 size = 2 + 4 + 8 + 4 + 2;
+	for ( const TYPE& object : objects ) {
+		size += getObjectSerializedSize( object ) + 8 + 4; // 8 bytes for size, 4 bytes for hash
+	}
+
+	unique_ptr<ui8[]> buffer( new ui8[size] );
+	ui8* pointer = buffer.get();
+
+	// beginning designation and CR version
+	pointer[0] = 0x73;
+	pointer[1] = 0x72;
+	pointer[2] = 0x00;
+	pointer[3] = (ui8)CR_MAJOR_VERSION;
+	pointer[4] = (ui8)CR_MINOR_VERSION;
+	pointer[5] = (ui8)CR_PATCH_VERSION;
+
+	LittleEndian::write( pointer + 14, (ui32)objects.size() );
+
+	// every object has the same class hash
+	i32 objectDefinitionHash = objects.empty() ? 0 : objects.front().TYPE::getClassHash();
+
+	i64 objectOffset = 18;
+	for ( const TYPE& object : objects ) {
+
+		i64 objectSize = getObjectSerializedSize( object );
+		LittleEndian::write( pointer + objectOffset, objectSize );
+		LittleEndian::write( pointer + objectOffset + sizeof( i64 ), objectDefinitionHash );
+
+		i64 written = serializeObject( object, pointer + objectOffset + sizeof( i64 ) + sizeof( i32 ));
+		if ( written != objectSize ) {
+			throw CRException(
+					"Serialized object did not write exactly its size (size=%ld, written=%ld)",
+					objectSize,
+					written );
+		}
+
+		objectOffset += (objectSize + sizeof( i64 ) + sizeof( i32 ));
+	}
+
+	// end designation
+	pointer[objectOffset] = 0x73;
+	pointer[objectOffset + 1] = 0x72;
+
+	return pair<i64, unique_ptr<ui8[]>>( size, std::move( buffer ));
+}
+
 // inflate
 template <typename TYPE>
 TYPE inflate( void* pointer ) {
 	TYPE obj;
-	obj.internalize( pointer );
+	internalizeObject( obj, pointer );
 	return obj;
 }
 
@@ -37,6 +114,29 @@ TYPE getObject( const vector<pair<i32, i64>>& contents, void* pointer, i64 itemI
 	return inflate<TYPE>( ((ui8*)pointer) + offset );
 }
 
+// getObject
+template <typename TYPE>
+i64 getObject( const vector<pair<i32, i64>>& contents, const void* pointer, i64 size, i64 itemIndex, TYPE& object ) {
+
+	if ( itemIndex < 0 || itemIndex >= (i64)contents.size() ) {
+		return -1;
+	}
+
+	// the object's size precedes its hash, just ahead of the object
+	i64 offset = contents[itemIndex].second;
+	if ( offset < (i64)(sizeof( i64 ) + sizeof( i32 )) || offset > size ) {
+		return -1;
+	}
+
+	i64 objectSize;
+	LittleEndian::read( ((const ui8*)pointer) + offset - sizeof( i64 ) - sizeof( i32 ), &objectSize );
+	if ( objectSize < 0 || objectSize > size - offset ) {
+		return -1;
+	}
+
+	return internalizeObject( object, ((const ui8*)pointer) + offset, objectSize );
+}
+
 }
 
 #endif
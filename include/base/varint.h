@@ -0,0 +1,105 @@
+#ifndef __CR_BASE_VARINT_H_
+#define __CR_BASE_VARINT_H_
+
+#include "core/types.h"
+
+namespace cr {
+
+/**
+ * Varints are how integer fields with encoding="varint" go on the wire: 7 bits per byte, least
+ * significant group first, with the high bit of each byte set if another follows. Values below 128
+ * take a single byte, and a 64 bit value at most MAX_SIZE bytes.
+ *
+ * Signed values are zigzag encoded first (0, -1, 1, -2... become 0, 1, 2, 3...), so that small
+ * negative numbers stay short too.
+ */
+namespace Varint {
+
+	/**
+	 * The most bytes a varint takes
+	 */
+	const i64 MAX_SIZE = 10;
+
+	/**
+	 * Map a signed value to an unsigned one whose magnitude follows the value's
+	 */
+	inline ui64 zigzagEncode( i64 value ) {
+		return ((ui64)value << 1) ^ (ui64)(value >> 63);
+	}
+
+	/**
+	 * Reverse zigzagEncode()
+	 */
+	inline i64 zigzagDecode( ui64 value ) {
+		return (i64)(value >> 1) ^ -(i64)(value & 1);
+	}
+
+	/**
+	 * Returns the number of bytes write() takes for the given value
+	 */
+	inline i64 getSize( ui64 value ) {
+		i64 size = 1;
+		while ( value >= 0x80 ) {
+			value >>= 7;
+			size++;
+		}
+		return size;
+	}
+
+	/**
+	 * Write the given value to buffer, returning the number of bytes written
+	 */
+	inline i64 write( void* buffer, ui64 value ) {
+		ui8* out = (ui8*)buffer;
+		i64 size = 0;
+		while ( value >= 0x80 ) {
+			out[size++] = (ui8)(value | 0x80);
+			value >>= 7;
+		}
+		out[size++] = (ui8)value;
+		return size;
+	}
+
+	/**
+	 * Read a value written by write(), returning the number of bytes read. No more than MAX_SIZE
+	 * bytes are read, even if the last of them says another follows.
+	 */
+	inline i64 read( const void* buffer, ui64* value ) {
+		const ui8* in = (const ui8*)buffer;
+		ui64 result = 0;
+		i64 size = 0;
+		ui8 byte;
+		do {
+			byte = in[size];
+			result |= (ui64)(byte & 0x7f) << (7 * size);
+			size++;
+		} while ( (byte & 0x80) && size < MAX_SIZE );
+		*value = result;
+		return size;
+	}
+
+	/**
+	 * Read a value like read(), but from no more than length bytes of buffer. Returns -1 if they end
+	 * before the value does.
+	 */
+	inline i64 read( const void* buffer, i64 length, ui64* value ) {
+		const ui8* in = (const ui8*)buffer;
+		ui64 result = 0;
+		i64 size = 0;
+		ui8 byte;
+		do {
+			if ( size >= length ) {
+				return -1;
+			}
+			byte = in[size];
+			result |= (ui64)(byte & 0x7f) << (7 * size);
+			size++;
+		} while ( (byte & 0x80) && size < MAX_SIZE );
+		*value = result;
+		return size;
+	}
+}
+
+}
+
+#endif
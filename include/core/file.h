@@ -148,6 +148,18 @@ class File {
 		 */
 		ui64 getSize() const;
 
+		/**
+		 * Writes the given contents to this file, unless the file already holds exactly those 
+		 * contents (in which case it, and its mtime, are left alone). Returns true if the file was
+		 * written.
+		 */
+		bool writeIfChanged( const string& contents ) const;
+
+		/**
+		 * Reads the whole file into contents. Returns false if it couldn't be read.
+		 */
+		bool readContents( string& contents ) const;
+
 		/**
 		 * Attempts to reload information about this file, Some information (whether the file exists
 		 * and whether it is a directory, etc.) is cached; some is not (such as size and mtime).
@@ -155,7 +167,8 @@ class File {
 		void refresh();
 
 		/**
-		 * Lists the contents of a directory.
+		 * Lists the contents of a directory (excluding "." and ".."). The returned files include 
+		 * this directory in their path.
 		 */
 		list<File> listFiles();
 
@@ -0,0 +1,88 @@
+#ifndef SYMBOL_H_INCLUDED
+#define SYMBOL_H_INCLUDED
+
+#include <string>
+
+namespace cr {
+
+using std::string;
+
+/**
+ * An interned string. All symbols with the same text share a single copy of it (which lives for the
+ * life of the process), so a symbol is a pointer wide, copying one never allocates, and comparing 
+ * two for equality is a pointer comparison.
+ *
+ * Creating a symbol from a string takes a lock; copying one does not.
+ */
+class Symbol {
+
+	public:
+
+		/**
+		 * Empty constructor -- the empty string
+		 */
+		Symbol();
+
+		/**
+		 * Constructor. Interns the given string.
+		 */
+		Symbol( const string& str );
+
+		/**
+		 * Constructor. Interns the given string.
+		 */
+		Symbol( const char* str );
+
+		/**
+		 * Returns the text of this symbol
+		 */
+		const string& str() const { return *_str; };
+
+		/**
+		 * Operator const string&
+		 */
+		operator const string&() const { return *_str; };
+
+		/**
+		 * Returns the text of this symbol as a C string
+		 */
+		const char* c_str() const { return _str->c_str(); };
+
+		/**
+		 * Returns the length of the text
+		 */
+		size_t size() const { return _str->size(); };
+
+		/**
+		 * Returns true if this is the empty symbol
+		 */
+		bool empty() const { return _str->empty(); };
+
+		/**
+		 * Operator []
+		 */
+		char operator[]( size_t index ) const { return (*_str)[index]; };
+
+		/**
+		 * Operator ==
+		 */
+		bool operator==( const Symbol& other ) const { return _str == other._str; };
+
+		/**
+		 * Operator !=
+		 */
+		bool operator!=( const Symbol& other ) const { return _str != other._str; };
+
+		/**
+		 * Operator < (orders by text, so that ordered containers of symbols are deterministic)
+		 */
+		bool operator<( const Symbol& other ) const { return _str != other._str && *_str < *other._str; };
+
+	private:
+
+		const string* _str;
+};
+
+} // namespace cr
+
+#endif // !SYMBOL_H_INCLUDED
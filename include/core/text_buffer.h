@@ -0,0 +1,134 @@
+#ifndef TEXT_BUFFER_H_INCLUDED
+#define TEXT_BUFFER_H_INCLUDED
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+#include "core/types.h"
+#include "core/file.h"
+
+namespace cr {
+
+using std::string;
+using std::vector;
+using std::unique_ptr;
+
+/**
+ * An append-only text buffer made of fixed size chunks. Unlike an ostringstream, appending never 
+ * moves what has already been written, the contents are never copied out to be hashed or written, 
+ * and bytes written earlier can be patched in place (for values which aren't known until later).
+ *
+ * The buffer can optionally hash everything appended after a given point as it is appended.
+ */
+class TextBuffer {
+
+	public:
+
+		/**
+		 * Constructor
+		 */
+		TextBuffer( size_t chunkSize = 16384 );
+
+		/**
+		 * Append raw bytes
+		 */
+		TextBuffer& append( const char* data, size_t length );
+
+		/**
+		 * Append a range of another buffer
+		 */
+		TextBuffer& append( const TextBuffer& other, size_t begin, size_t end );
+
+		/**
+		 * Operator << (C string)
+		 */
+		TextBuffer& operator<<( const char* str );
+
+		/**
+		 * Operator << (string)
+		 */
+		TextBuffer& operator<<( const string& str ) { return append( str.data(), str.size() ); };
+
+		/**
+		 * Operator << (char)
+		 */
+		TextBuffer& operator<<( char c ) { return append( &c, 1 ); };
+
+		/**
+		 * Operator << (integers, written in decimal)
+		 */
+		template<typename INT>
+		typename std::enable_if<std::is_integral<INT>::value && ! std::is_same<INT, char>::value && ! std::is_same<INT, bool>::value, TextBuffer&>::type
+		operator<<( INT value ) {
+			return std::is_signed<INT>::value ? appendSigned( (i64)value ) : appendUnsigned( (ui64)value );
+		}
+
+		/**
+		 * Operator << (manipulators such as endl)
+		 */
+		TextBuffer& operator<<( TextBuffer& (*manipulator)( TextBuffer& ) ) { return manipulator( *this ); };
+
+		/**
+		 * Returns the number of bytes in the buffer
+		 */
+		size_t size() const { return _size; };
+
+		/**
+		 * Start hashing (see hash() in cr_util.h) everything appended from here on.
+		 */
+		void startHash();
+
+		/**
+		 * Returns the hash of everything appended since startHash() was called.
+		 */
+		ui32 getHash() const { return _hash; };
+
+		/**
+		 * Overwrite bytes previously written at the given offset. This does not affect the hash.
+		 */
+		void patch( size_t offset, const char* data, size_t length );
+
+		/**
+		 * Returns a copy of the contents. This is meant for debugging and tests; prefer writeTo().
+		 */
+		string str() const;
+
+		/**
+		 * Write the contents to the given file with a single writev(), unless the file already holds
+		 * exactly these contents (in which case it, and its mtime, are left alone). Returns true if
+		 * the file was written.
+		 */
+		bool writeTo( const File& file ) const;
+
+	private:
+
+		/**
+		 * Append integers
+		 */
+		TextBuffer& appendSigned( i64 value );
+		TextBuffer& appendUnsigned( ui64 value );
+
+		/**
+		 * Compare the contents to the file at the given path
+		 */
+		bool matchesFile( const string& path ) const;
+
+		vector<unique_ptr<char[]>> _chunks;
+		size_t _chunkSize;
+		size_t _size;
+		bool _hashing;
+		ui32 _hash;
+};
+
+/**
+ * End a line
+ */
+inline TextBuffer& endl( TextBuffer& buffer ) {
+	return buffer << '\n';
+}
+
+} // namespace cr
+
+#endif // !TEXT_BUFFER_H_INCLUDED
@@ -9,6 +9,14 @@
 #define CR_MINOR_VERSION 1
 #define CR_PATCH_VERSION 1
 
+// name of the file (in the output dir) that remembers class fingerprints between runs
+#define CR_FINGERPRINT_FILE_NAME ".coderoller.fingerprints"
+#define CR_SCHEMA_CACHE_DIR_NAME ".coderoller.cache"
+#define CR_INPUT_FILE_SUFFIX ".cr.xml"
+
+// objects a generated Foo::Pool keeps per thread, until changed with Foo::Pool::setCapacity()
+#define CR_DEFAULT_POOL_CAPACITY 1024
+
 namespace cr {
 
 /**
@@ -60,6 +68,67 @@ enum class SerializableSpecification {
 	NO
 };
 
+/**
+ * Enum representing how a class's fields are laid out in memory (unspecified, in declaration order,
+ * or reordered to minimize padding)
+ */
+enum class FieldLayout {
+	NONE = 0,
+	DECLARATION,
+	COMPACT
+};
+
+/**
+ * Enum representing how generated sources are grouped: one per class, one unity source per package
+ * (input file), or a fixed number of unity sources
+ */
+enum class UnityOutput {
+	NONE = 0,
+	PACKAGE,
+	SHARDS
+};
+
+/**
+ * Enum representing where a class's accessors, move operations and copy functions are defined
+ * (unspecified, out of line in the .gen.cpp, or inline in the .gen.h)
+ */
+enum class AccessorDefinition {
+	NONE = 0,
+	OUT_OF_LINE,
+	INLINE
+};
+
+/**
+ * Enum representing where a class's strings and blobs allocate their storage (unspecified, the
+ * default heap, or a std::pmr::memory_resource passed to the class's constructors)
+ */
+enum class AllocatorKind {
+	NONE = 0,
+	DEFAULT,
+	PMR
+};
+
+/**
+ * Enum representing how a serializable class's serialization functions are called (unspecified,
+ * virtually through the Serializable interface, or statically on the concrete class, which then has
+ * no vtable)
+ */
+enum class SerializationDispatch {
+	NONE = 0,
+	VIRTUAL,
+	STATIC
+};
+
+/**
+ * Enum representing how integer fields are written on the wire (unspecified, at their full width,
+ * or as varints, zigzag encoded if signed)
+ */
+enum class IntegerEncoding {
+	NONE = 0,
+	FIXED,
+	VARINT
+};
+
 /** 
  * InvalidNodeNameException
  */
@@ -3,19 +3,32 @@
 
 #include <memory>
 #include <map>
+#include <list>
 
 #include "core/file.h"
 
 #include "languages/generator.h"
+#include "stats_report.h"
 
 using std::map;
 using std::shared_ptr;
+using std::list;
 
 namespace cr {
 
 // command line config
-extern File g_inputFile;
+extern list<File> g_inputFiles;
 extern File g_outputDir;
+extern i32 g_jobs; // number of worker threads used for generation
+extern bool g_deterministic; // omit anything (timestamps) that differs between identical runs
+extern bool g_watch; // keep running and regenerate when inputs change
+extern File g_depfile; // if valid, where to write a Make/Ninja depfile
+extern File g_outputManifest; // if valid, where to write the list of generated files
+extern File g_schemaCacheDir; // if valid, where parsed inputs are cached
+extern StatsFormat g_statsFormat; // machine readable stats report to produce, if any
+extern File g_statsFile; // if valid, where to write the stats report (otherwise stdout)
+extern UnityOutput g_unityOutput; // how generated sources are grouped into translation units
+extern i32 g_unityShards; // number of unity sources for UnityOutput::SHARDS
 
 /**
  * Store generators for each language
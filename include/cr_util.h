@@ -1,6 +1,8 @@
 #ifndef __CR_CR_UTIL_H_
 #define __CR_CR_UTIL_H_
 
+#include <functional>
+
 #include "cr_constants.h"
 #include "core/types.h"
 
@@ -26,6 +28,52 @@ AccessPrivacy toAccessPrivacy( const char* str );
  */
 SerializableSpecification toSerializableSpecification( const char* str );
 
+/**
+ * Returns the FieldLayout from the given input ("declaration" or "compact")
+ */
+FieldLayout toFieldLayout( const char* str );
+
+/**
+ * Returns the AccessorDefinition from the given input ("outOfLine" or "inline")
+ */
+AccessorDefinition toAccessorDefinition( const char* str );
+
+/**
+ * Returns the AllocatorKind from the given input ("default" or "pmr")
+ */
+AllocatorKind toAllocatorKind( const char* str );
+
+/**
+ * Returns the SerializationDispatch from the given input ("virtual" or "static")
+ */
+SerializationDispatch toSerializationDispatch( const char* str );
+
+/**
+ * Returns the IntegerEncoding from the given input ("fixed" or "varint")
+ */
+IntegerEncoding toIntegerEncoding( const char* str );
+
+/**
+ * Returns true if the given DataType is an integer (signed or not, of any width)
+ */
+bool isInteger( DataType type );
+
+/**
+ * Returns true if the given DataType is a signed integer
+ */
+bool isSignedInteger( DataType type );
+
+/**
+ * Returns the boolean value of the given input ("true"/"yes" or "false"/"no"), or defaultValue if
+ * there is none
+ */
+bool toBoolean( const char* str, bool defaultValue );
+
+/**
+ * Returns the positive integer value of the given input, or defaultValue if there is none
+ */
+ui32 toPositiveInteger( const char* str, ui32 defaultValue );
+
 /**
  * Capitalize a letter
  */
@@ -36,11 +84,46 @@ char capitalize( char c );
  */
 ui32 hash( const char* str, ui32 h = 0 );
 
+/**
+ * Compute a 64 bit FNV-1a hash of the given bytes. Pass a previous result as h to hash incrementally.
+ */
+ui64 hash64( const void* data, size_t size, ui64 h = 0xcbf29ce484222325ULL );
+
+/**
+ * Compute a 64 bit FNV-1a hash of the given string (including its terminator, so that consecutive
+ * strings can't run into each other).
+ */
+ui64 hash64( const string& str, ui64 h = 0xcbf29ce484222325ULL );
+
+/**
+ * Return a hash identifying this build of coderoller: the git hash, and the bytes of the running
+ * executable (read once, on the first call), so that any rebuild changes it, even one from a dirty
+ * tree or without reconfiguring. Where the executable can't be read, only the git hash is used.
+ */
+ui64 getBuildHash();
+
 /**
  * Return the time since epoch in millis. This comes from the stable[-ish] system clock.
  */
 ui64 getTimeMillis();
 
+/**
+ * Return the peak resident set size of this process so far, in bytes (0 if unknown).
+ */
+ui64 getPeakMemoryBytes();
+
+/**
+ * Return the number of hardware threads available (at least 1).
+ */
+i32 getCoreCount();
+
+/**
+ * Call fn( i ) for each i in [0, count) using up to the given number of worker threads. Work is
+ * handed out one index at a time. If any call throws, the remaining work is abandoned and the first
+ * exception is rethrown on the calling thread once all workers have finished.
+ */
+void parallelFor( size_t count, i32 jobs, const std::function<void(size_t)>& fn );
+
 };
 
 #endif
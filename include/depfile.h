@@ -0,0 +1,27 @@
+#ifndef __CR_DEPFILE_H_
+#define __CR_DEPFILE_H_
+
+#include "core/file.h"
+
+#include "gen_stats.h"
+
+namespace cr {
+
+/**
+ * Write a Make/Ninja style depfile listing every generated file along with the input it was
+ * generated from, e.g.:
+ *
+ *     out/include/Foo.gen.h out/src/Foo.gen.cpp: schema/foo.cr.xml
+ *
+ * Every output of the run is listed, including those that were up to date and not rewritten.
+ */
+void writeDepfile( const File& file, const GenStats& stats );
+
+/**
+ * Write a manifest of every generated file, one per line, as "<output>\t<input>".
+ */
+void writeOutputManifest( const File& file, const GenStats& stats );
+
+}
+
+#endif
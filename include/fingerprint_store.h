@@ -0,0 +1,72 @@
+#ifndef __CR_FINGERPRINT_STORE_H_
+#define __CR_FINGERPRINT_STORE_H_
+
+#include <map>
+#include <string>
+
+#include "core/types.h"
+#include "core/file.h"
+
+using std::map;
+using std::string;
+
+namespace cr {
+
+/**
+ * Remembers the fingerprint of each class (and of the membership of each unity source, keyed by its
+ * file name) as of the last time its output was generated, so that a later run can skip classes
+ * whose fingerprint hasn't changed. The store is persisted as a small text
+ * file (one "name fingerprint" pair per line) in the output dir.
+ *
+ * Lookups are safe to do concurrently; updates are not.
+ */
+class FingerprintStore {
+
+public:
+
+	/**
+	 * Constructor
+	 */
+	FingerprintStore();
+
+	/**
+	 * Load the store from the given file, replacing the current contents. A missing or unreadable
+	 * file results in an empty store.
+	 */
+	void load( const File& file );
+
+	/**
+	 * Write the store to the file it was loaded from, if it changed since.
+	 */
+	void save();
+
+	/**
+	 * Returns the file this store was loaded from.
+	 */
+	const File& getFile() const { return _file; };
+
+	/**
+	 * Returns true if the given key was last recorded with the given fingerprint.
+	 */
+	bool matches( const string& key, ui64 fingerprint ) const;
+
+	/**
+	 * Record the fingerprint for the given key.
+	 */
+	void set( const string& key, ui64 fingerprint );
+
+	/**
+	 * Forget the given key, forcing it to be considered out of date.
+	 */
+	void erase( const string& key );
+
+private:
+
+	File _file;
+	map<string, ui64> _fingerprints;
+	bool _dirty;
+};
+
+};
+
+#endif
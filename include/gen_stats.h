@@ -0,0 +1,53 @@
+#ifndef __CR_GEN_STATS_H_
+#define __CR_GEN_STATS_H_
+
+#include <string>
+#include <vector>
+
+#include "core/types.h"
+
+using std::string;
+using std::vector;
+
+namespace cr {
+
+/**
+ * Stats for a single generated file.
+ */
+struct OutputFileStats {
+
+	string _path;
+	ui64 _bytes; // size of the generated contents (or of the existing file, if the class was skipped)
+	bool _written; // the file was rewritten (false if it was up to date)
+};
+
+/**
+ * Stats collected while generating a single class.
+ */
+struct ClassGenStats {
+
+	string _className;
+	string _inputFile; // the input the class was defined in
+	vector<OutputFileStats> _outputs; // every file generated for the class, whether or not it was rewritten.
+			// A unity source shared by several classes is listed by each, but its bytes and write are only
+			// counted for the first of them
+	ui64 _genTimeNanos; // total time spent on the class, including _writeTimeNanos
+	ui64 _writeTimeNanos; // time spent comparing and writing output files
+	ui64 _layoutBytes; // estimated sizeof the generated class (not counting nested objects)
+	ui64 _paddingBytes; // bytes of _layoutBytes which are padding
+	bool _skipped; // class was up to date
+	i32 _filesWritten; // files actually rewritten (unchanged files are left alone)
+};
+
+/**
+ * Stats collected over a generation run. Generators reserve one ClassGenStats slot per class up
+ * front so that workers can fill in their own slot without locking.
+ */
+struct GenStats {
+
+	vector<ClassGenStats> _classes;
+};
+
+};
+
+#endif
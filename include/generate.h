@@ -2,17 +2,31 @@
 #define __CR_GENERATE_H_
 
 #include <memory>
+#include <vector>
 
+#include "gen_stats.h"
 #include "meta.h"
 
 using std::shared_ptr;
+using std::vector;
 
 namespace cr {
 
 /**
- * Generate code.
+ * Generate code. Per-class stats are appended to the given stats.
  */
-void generateAll( shared_ptr<GenConfig> config );
+void generateAll( shared_ptr<GenConfig> config, GenStats& stats );
+
+/**
+ * Generate code for a batch of configs sharing an output dir. Each generator runs once over all of
+ * the configs which ask for its language. Per-class stats are appended to the given stats.
+ */
+void generateAll( const vector<shared_ptr<GenConfig>>& configs, GenStats& stats );
+
+/**
+ * Make every generator regenerate the given class the next time it is generated.
+ */
+void invalidateAll( const string& className );
 
 }
 
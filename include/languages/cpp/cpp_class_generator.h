@@ -2,15 +2,14 @@
 #define __CR_CPP_CLASS_GENERATOR_H_
 
 #include <memory>
-#include <iostream>
-#include <sstream>
 
+#include "core/text_buffer.h"
 #include "languages/generator.h"
 #include "cr_constants.h"
+#include "gen_stats.h"
 #include "meta.h"
 
 using std::shared_ptr;
-using std::ostringstream;
 
 namespace cr {
 
@@ -22,9 +21,11 @@ class CPPClassGenerator {
 public:
 
 	/** 
-	 * Constructor
+	 * Constructor. If keepSource is true, generate() only writes the header, and keeps the source's
+	 * definitions (without the includes it needs, see getSourceIncludes()) to be gathered into a
+	 * unity source.
 	 */
-	CPPClassGenerator();
+	CPPClassGenerator( bool keepSource = false );
 
 	/**
 	 * Virtual destructor
@@ -32,7 +33,9 @@ public:
 	virtual ~CPPClassGenerator();
 
 	/**
-	 * Generate code
+	 * Generate code. Files whose contents didn't change are not rewritten. The size of each file
+	 * and whether it was written are recorded in stats._outputs, which must already hold the
+	 * header and source file entries (in that order).
 	 */
 	virtual void generate( 
 			shared_ptr<GenConfig> config, 
@@ -40,15 +43,59 @@ public:
 			const string& includeRoot,
 			const string& hFilePath, 
 			const string& sourceRoot,
-			const string& cppFilePath );
+			const string& cppFilePath,
+			ClassGenStats& stats );
+
+	/**
+	 * Returns the headers the generated source includes (relative to the include root)
+	 */
+	const vector<string>& getSourceIncludes() const { return _sourceIncludes; };
+
+	/**
+	 * Returns the generated source definitions (only kept if constructed with keepSource)
+	 */
+	const TextBuffer& getSource() const { return _cppStream; };
 
 private:
 
-	ostringstream _hStream;
-	ostringstream _cppStream;
+	bool _keepSource;
+	vector<string> _sourceIncludes;
+
+	TextBuffer _hStream;
+	TextBuffer _cppStream;
+	TextBuffer _inlineStream; // inline definitions, appended to _hStream after the class
+	bool _inlineAccessors;
+	bool _coldOutOfLine; // the cold struct is only declared in the header
+	bool _inlineSerialization; // serialization functions are defined in the header (static dispatch, inline accessors)
 	i64 _hashPosition1;
 	i64 _hashPosition2;
 
+	/**
+	 * Returns the stream accessor, move and copy function definitions are written to
+	 */
+	TextBuffer& getDefinitionStream() { return _inlineAccessors ? _inlineStream : _cppStream; };
+
+	/**
+	 * Returns the specifier to start those definitions with ("inline " or nothing)
+	 */
+	const char* getDefinitionSpecifier() const { return _inlineAccessors ? "inline " : ""; };
+
+	/**
+	 * Returns the stream serialization function definitions are written to. Virtual ones always go in
+	 * the .gen.cpp, so that the vtable is only emitted there.
+	 */
+	TextBuffer& getSerializationStream() { return _inlineSerialization ? _inlineStream : _cppStream; };
+
+	/**
+	 * Returns the specifier to start those definitions with ("inline " or nothing)
+	 */
+	const char* getSerializationSpecifier() const { return _inlineSerialization ? "inline " : ""; };
+
+	/**
+	 * Returns the specifier for accessors which may be constexpr (see writeConstexprDef)
+	 */
+	const char* getConstexprSpecifier( const Field& f ) const;
+
 	/** 
 	 * Write a field
 	 */
@@ -79,6 +126,21 @@ private:
 	 */
 	void writeHashDef( const Class& c );
 
+	/** 
+	 * Write the __CR_CONSTEXPR def used by inline accessors
+	 */
+	void writeConstexprDef();
+
+	/** 
+	 * Write the cr::FixedString template used by strings with a maxLength
+	 */
+	void writeFixedStringDef();
+
+	/** 
+	 * Write the cr::makeUsingAllocator template used by allocator-aware ctors
+	 */
+	void writeMakeUsingAllocatorDef();
+
 	/** 
 	 * Write the main header
 	 */
@@ -89,6 +151,26 @@ private:
 	 */
 	void writeConstructors( const Class& c );
 
+	/**
+	 * Write copyFrom() and clone()
+	 */
+	void writeCopyFunctions( const Class& c );
+
+	/**
+	 * Write the allocator-aware constructors of a class allocating from a memory resource
+	 */
+	void writeAllocatorConstructors( const Class& c );
+
+	/**
+	 * Returns the noexcept specifier of the class's custom (or out of line) move ctor or assignment
+	 */
+	string getMoveNoexceptSpecifier( const Class& c, bool assignment ) const;
+
+	/**
+	 * Write the static_assert that a class of primitives is trivially copyable
+	 */
+	void writeTriviallyCopyableAssert( const Class& c );
+
 	/**
 	 * Write move assignment for the given field
 	 */
@@ -108,6 +190,43 @@ private:
 	 * Write a field
 	 */
 	void writeField( const Field& f );
+	void writeField( const Field& f, TextBuffer& out );
+
+	/** 
+	 * Write all fields with the given privacy
+	 */
+	void writeFields( const Class& c, AccessPrivacy privacy );
+
+	/** 
+	 * Write every field in compact layout order, switching access specifiers as needed
+	 */
+	void writeCompactFields( const Class& c );
+
+	/** 
+	 * Write the words holding the class's packed bools
+	 */
+	void writePackedBoolWords( const Class& c );
+
+	/** 
+	 * Write the cold struct holding the given fields, its pointer and the functions to reach it
+	 */
+	void writeColdFields( const Class& c, const vector<const Field*>& coldFields );
+
+	/** 
+	 * Write the definition of the out of line cold struct (to the source)
+	 */
+	void writeColdStructDefinition( const Class& c );
+
+	/** 
+	 * Returns the object types which only the out of line cold struct holds, and which the header 
+	 * therefore only declares
+	 */
+	vector<Symbol> getForwardDeclaredTypes( const Class& c ) const;
+
+	/** 
+	 * Returns true if the class has any fields with the given privacy
+	 */
+	static bool hasFields( const Class& c, AccessPrivacy privacy );
 
 	/** 
 	 * Write a field accessors
@@ -122,28 +241,99 @@ private:
 	/**
 	 * Substitute the hash code at the given position
 	 */
-	void substituteHash( i32 hash, i64 streamPos );
+	void substituteHash( i32 hash, i64 position );
 
 	/**
 	 * Write the serialization function declarations
 	 */
-	void writeSerializationDeclarations();
+	void writeSerializationDeclarations( const Class& c );
+
+	/**
+	 * Write the serialized size and packed Wire struct of a class whose wire format has a fixed size
+	 */
+	void writeWireDeclarations( const Class& c, ui64 serializedSize );
 
 	/**
 	 * Write the serialization function definitions
 	 */
-	void writeSerializationDefinitions( const Class& c, list<Field>& publicFields, list<Field>& protectedFields, list<Field>& privateFields );
+	void writeSerializationDefinitions( const Class& c );
 
-	void writeSerialize( const Class& c, list<Field>& publicFields, list<Field>& protectedFields, list<Field>& privateFields );
+	void writeSerialize( const Class& c );
 	void writeSerializeField( const Field& f );
+	void writeSerializeBytes( TextBuffer& out, const string& value, const char* indent );
+	void writeSerializePackedBools( const Class& c );
 
-	void writeGetSerializedSize( const Class& c, list<Field>& publicFields, list<Field>& protectedFields, list<Field>& privateFields );
+	void writeGetSerializedSize( const Class& c );
 	void writeGetSerializedSizeField( const Field& f );
+	void writeGetSerializedSizePackedBools( const Class& c );
 
-	void writeInternalize( const Class& c, list<Field>& publicFields, list<Field>& protectedFields, list<Field>& privateFields );
+	void writeInternalize( const Class& c );
 	void writeInternalizeField( const Field& f );
+	void writeInternalizeBytes( TextBuffer& out, const Field& f, const string& value, const char* indent, i64 followingSize );
+	void writeInternalizeVarint( TextBuffer& out, const Field& f, const string& value, const char* indent, i64 followingSize );
+	void writeInternalizePackedBools( const Class& c );
+
+	/**
+	 * Write internalize( const void*, i64 ), which checks the serialized size against the buffer size
+	 * as it goes, returning -1 rather than reading past the end. Every check covers as many bytes as it
+	 * can, so there is one per variable size field (the fixed size fields are covered along the way).
+	 *
+	 * The bytes, varint and bounds check writers take the number of checked bytes following the
+	 * value they read, or -1 if the function they are writing doesn't check bounds.
+	 */
+	void writeCheckedInternalize( const Class& c );
+	void writeBoundsCheck( TextBuffer& out, const string& condition, const char* indent );
 
 	void writeGetClassHash( const Class& c );
+
+	/**
+	 * Write serialize, getSerializedSize and internalize for a class whose wire format has a fixed
+	 * size: each copies the Wire struct at once
+	 */
+	void writeWireSerializationDefinitions( const Class& c );
+
+	/**
+	 * Write the struct of arrays container (FooColumns) for the class
+	 */
+	void writeColumns( const Class& c );
+
+	/**
+	 * Write the thread local free list (Foo::Pool) recycling objects of the class
+	 */
+	void writePool( const Class& c );
+
+	/**
+	 * Write the statement the pool uses to reset the given field of a released object, keeping the
+	 * capacity of strings and blobs
+	 */
+	void writePoolFieldReset( const Field& f, const string& object );
+
+	/**
+	 * Write the declaration of the container's mutable (Row) or const (ConstRow) row view
+	 */
+	void writeColumnsRowDeclaration( const Class& c, bool isConst );
+
+	/**
+	 * Write the definitions of the accessors of a row view
+	 */
+	void writeColumnsRowDefinitions( const Class& c, bool isConst );
+
+	/**
+	 * Write the definitions of the container's batch serialization functions
+	 */
+	void writeColumnsSerializationDefinitions( const Class& c );
+
+	/**
+	 * Write the container's internalize, or (if checked) its bounds checked internalize, which reads
+	 * each row the way the class's own bounds checked internalize does
+	 */
+	void writeColumnsInternalize( const Class& c, bool checked );
+
+	/**
+	 * Write the code packing a row's bool columns into the class's packed bool words for batch 
+	 * serialize (or unpacking them, for internalize)
+	 */
+	void writeColumnsPackedBools( const Class& c, bool internalize );
 };
 
 };
@@ -3,13 +3,21 @@
 
 #include <memory>
 #include <iostream>
+#include <utility>
+#include <vector>
 
+#include "core/text_buffer.h"
 #include "languages/generator.h"
+#include "languages/cpp/cpp_class_generator.h"
 #include "cr_constants.h"
+#include "fingerprint_store.h"
 #include "meta.h"
 
 using std::shared_ptr;
 using std::ostream;
+using std::pair;
+using std::unique_ptr;
+using std::vector;
 
 namespace cr {
 
@@ -33,7 +41,47 @@ public:
 	/**
 	 * Generate code
 	 */
-	virtual void generate( shared_ptr<GenConfig> config );
+	virtual void generate( const vector<shared_ptr<GenConfig>>& configs, GenStats& stats );
+
+	/**
+	 * Invalidate a class
+	 */
+	virtual void invalidate( const string& className );
+
+private:
+
+	/**
+	 * A unity source and the classes (indexes into the batch) whose definitions it holds
+	 */
+	struct UnityShard {
+		File _file;
+		vector<size_t> _classes;
+		bool _skipped; // all of its classes are up to date, and none joined or left it
+		ui64 _fingerprint; // of its membership
+	};
+
+	// fingerprints of the classes generated into the output dir; kept between calls
+	FingerprintStore _fingerprints;
+
+	/**
+	 * Create the unity sources for the batch: one per config, or g_unityShards of them
+	 */
+	void assignUnityShards( const vector<shared_ptr<GenConfig>>& configs, const File& sourceDir, vector<UnityShard>& shards );
+
+	/**
+	 * Warn about unity sources in the source dir which this batch doesn't write (left over from a run
+	 * with a different --unity), since they'd define their classes a second time
+	 */
+	void reportStaleUnitySources( const File& sourceDir, const vector<UnityShard>& shards );
+
+	/**
+	 * Write a unity source: the includes its classes need, deduplicated, then their definitions
+	 */
+	void writeUnitySource(
+			TextBuffer& source,
+			const UnityShard& shard,
+			const vector<pair<shared_ptr<GenConfig>, const Class*>>& classes,
+			const vector<unique_ptr<CPPClassGenerator>>& generators );
 
 };
 
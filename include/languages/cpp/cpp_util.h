@@ -3,6 +3,7 @@
 
 #include <memory>
 #include <iostream>
+#include <vector>
 
 #include "languages/generator.h"
 #include "cr_constants.h"
@@ -10,6 +11,7 @@
 
 using std::shared_ptr;
 using std::ostream;
+using std::vector;
 
 namespace cr {
 
@@ -18,25 +20,110 @@ namespace cr {
  */
 const char* getDataTypeName( DataType type );
 
+/**
+ * Returns the size in bytes of a primitive DataType (0 for strings, blobs and objects)
+ */
+ui32 getDataTypeSize( DataType type );
+
+/**
+ * Return the C++ type of the given field
+ */
+string getFieldTypeName( const Field& f );
+
+/**
+ * Returns true if the given field is a string stored inline (in a cr::FixedString) rather than in a
+ * std::string
+ */
+bool isFixedString( const Field& f );
+
+/**
+ * Returns the size in bytes of the length of a cr::FixedString with the given capacity: the
+ * smallest unsigned type holding it
+ */
+ui32 getFixedStringLengthBytes( ui32 maxLength );
+
 /**
  * Return the C++ access specifier for the given AccessPrivacy
  */
 const char* getPrivacyName( AccessPrivacy privacy );
 
 /**
- * Resolve the desired access privacy for the given field
+ * Returns the number of bits in each word holding the class's packed bools: the smallest unsigned 
+ * type holding all of them, up to 64 bits (more bools take more words). Returns 0 if the class 
+ * doesn't pack its bools.
  */
-AccessPrivacy resolvePrivacy( const Package& p, const Class& c, const Field& f );
+ui32 getPackedBoolWordBits( const Class& c );
+
+/**
+ * Returns the number of words holding the class's packed bools
+ */
+ui32 getPackedBoolWordCount( const Class& c );
+
+/**
+ * Returns the C++ type of the words holding the class's packed bools
+ */
+const char* getPackedBoolWordType( const Class& c );
+
+/**
+ * Returns the member name of the given word of the class's packed bools ("_packedBools" if there is
+ * only one, otherwise "_packedBools0" and so on)
+ */
+string getPackedBoolWordName( const Class& c, ui32 word );
+
+/**
+ * Call fn for each field, ordered by privacy section (public, protected, then private) and then by
+ * declaration. This is the order fields are serialized in, and declared in unless the class uses the
+ * compact layout.
+ */
+template<typename FN>
+void forEachField( const Class& c, FN fn ) {
+
+	static const AccessPrivacy sectionOrder[] = {
+		AccessPrivacy::PUBLIC,
+		AccessPrivacy::PROTECTED,
+		AccessPrivacy::PRIVATE
+	};
+
+	for ( AccessPrivacy privacy : sectionOrder ) {
+		for ( const Field& f : c._fields ) {
+			if ( f._privacy == privacy ) {
+				fn( f );
+			}
+		}
+	}
+}
+
+/**
+ * The in-memory layout of a generated class
+ */
+struct ClassLayout {
+
+	vector<const Field*> _fields; // inline fields (other than packed bools), in the order they are declared
+	vector<const Field*> _coldFields; // fields stored in the cold struct, in the order they are declared
+	ui64 _size; // estimated sizeof the class (the cold struct itself isn't counted, only its pointer)
+	ui64 _padding; // bytes of _size which are padding
+	bool _exact; // false if the class holds objects or blobs, whose sizes aren't counted
+};
 
 /**
- * Resolve the desired serializable for the given class
+ * Compute the layout of the given class, either in section order or (if compact) with fields
+ * ordered by decreasing alignment, which minimizes padding. Sizes assume an LP64 target and 
+ * libstdc++ (where std::string is 32 bytes) and that serializable classes hold a vtable pointer
+ * (unless their dispatch is static).
+ *
+ * The words holding packed bools (if any) follow the inline fields. The pointer to the cold struct 
+ * (if any) follows them, or in the compact layout, precedes the inline fields.
  */
-bool resolveClassSerializable( const Package& p, const Class& c );
+ClassLayout computeClassLayout( const Class& c, bool compact );
 
 /**
- * Resolve the desired serializable for the given field
+ * Compute a fingerprint of everything that affects the generated output for the given class: the
+ * resolved class and field specifications, the generator build (see getBuildHash()) and output
+ * options (including the unity output mode, which decides where its source goes). If this doesn't
+ * change, the output doesn't either. The package's defaults are already resolved into the class's
+ * settings, so the package itself isn't needed.
  */
-bool resolveFieldSerializable( const Package& p, const Class& c, const Field& f );
+ui64 computeClassFingerprint( const Class& c );
 
 };
 
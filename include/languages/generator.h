@@ -2,11 +2,14 @@
 #define __CR_GENERATOR_H_
 
 #include <memory>
+#include <vector>
 
 #include "cr_constants.h"
+#include "gen_stats.h"
 #include "meta.h"
 
 using std::shared_ptr;
+using std::vector;
 
 namespace cr {
 
@@ -23,9 +26,16 @@ public:
 	virtual ~CodeGenerator() {};
 
 	/**
-	 * Generate code
+	 * Generate code for a batch of configs sharing an output dir. Classes from all of the configs
+	 * are generated together, and per-class stats are appended to the given stats.
 	 */
-	virtual void generate( shared_ptr<GenConfig> config ) = 0;
+	virtual void generate( const vector<shared_ptr<GenConfig>>& configs, GenStats& stats ) = 0;
+
+	/**
+	 * Forget anything remembered about the given class so that the next generate() call 
+	 * regenerates it even if its definition hasn't changed.
+	 */
+	virtual void invalidate( const string& /*className*/ ) {}
 };
 
 };
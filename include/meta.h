@@ -3,14 +3,17 @@
 
 #include <string>
 #include <list>
+#include <vector>
 
 #include "core/types.h"
 #include "core/file.h"
+#include "core/symbol.h"
 
 #include "cr_constants.h"
 
 using std::string;
 using std::list;
+using std::vector;
 
 namespace cr {
 
@@ -19,13 +22,24 @@ namespace cr {
  */
 struct Field {
 
-	string _name;
+	Symbol _name;
 	AccessPrivacy _memberPrivacy;
 	DataType _dataType;
-	string _typeName; // for object types, indicates the objects type name
-	string _defaultValue;
+	Symbol _typeName; // for object types, indicates the objects type name
+	Symbol _defaultValue;
 	SerializableSpecification _serializable;
-
+	bool _hot; // frequently accessed; if any field of a class is hot, the others are stored out of line
+	ui32 _maxLength; // for strings, the capacity of their inline storage (0 for an unbounded string)
+	IntegerEncoding _encoding; // for integers, how they are written on the wire
+
+	// filled in by resolvePackage()
+	Symbol _capitalizedName; // name with the first letter capitalized (for accessors)
+	AccessPrivacy _privacy; // the effective privacy
+	bool _serialized; // whether the field is serialized (its class must be serializable, too)
+	bool _cold; // whether the field is stored in the class's lazily allocated cold struct
+	i32 _bitIndex; // the bit holding the field in its class's packed bools, or -1 if it isn't packed
+	bool _pmr; // whether the field is a string or blob allocating from its class's memory resource
+	bool _varint; // whether the field is a serialized integer written as a varint
 };
 
 /**
@@ -33,11 +47,27 @@ struct Field {
  */
 struct Class {
 
-	string _name;
+	Symbol _name;
 	AccessPrivacy _defaultMemberPrivacy;
-	list<Field> _fields;
+	vector<Field> _fields;
 	SerializableSpecification _serializable;
-
+	FieldLayout _layout;
+	AccessorDefinition _accessors;
+	AllocatorKind _allocator;
+	SerializationDispatch _dispatch;
+	IntegerEncoding _encoding; // default encoding of the class's integer fields
+	bool _columns; // whether to also generate a struct of arrays container (FooColumns)
+	bool _packBools; // whether to pack bool fields into the bits of one or more words
+	bool _pool; // whether to also generate a thread local free list recycling objects (Foo::Pool)
+
+	// filled in by resolvePackage()
+	bool _serialized; // whether the class is serializable
+	bool _compactLayout; // whether fields are stored ordered by alignment rather than by declaration
+	bool _hasColdFields; // whether some fields are hot, and the rest are stored out of line
+	bool _inlineAccessors; // whether accessors, moves and copy functions are defined in the header
+	bool _pmr; // whether strings and blobs allocate from a std::pmr::memory_resource
+	bool _staticDispatch; // whether a serialized class skips the Serializable interface (and its vtable)
+	ui32 _packedBoolCount; // number of bool fields packed into bits (0 if bools aren't packed)
 };
 
 /**
@@ -45,8 +75,12 @@ struct Class {
  */
 struct Package {
 	AccessPrivacy _defaultMemberPrivacy;
-	list<Class> _classes;
+	vector<Class> _classes;
 	SerializableSpecification _defaultSerializable;
+	FieldLayout _defaultLayout;
+	AccessorDefinition _defaultAccessors;
+	AllocatorKind _defaultAllocator;
+	SerializationDispatch _defaultDispatch;
 };
 
 /**
@@ -56,10 +90,58 @@ struct GenConfig {
 
 	Package _package;
 	list<Language> _languages;
+	File _inputFile;
 	File _outputDir;
 	ui64 _mTime;
 };
 
+/**
+ * Resolve the desired access privacy for the given field
+ */
+AccessPrivacy resolvePrivacy( const Package& p, const Class& c, const Field& f );
+
+/**
+ * Resolve the desired serializable for the given class
+ */
+bool resolveClassSerializable( const Package& p, const Class& c );
+
+/**
+ * Resolve the desired serializable for the given field
+ */
+bool resolveFieldSerializable( const Package& p, const Class& c, const Field& f );
+
+/**
+ * Resolve the desired field layout for the given class
+ */
+FieldLayout resolveClassLayout( const Package& p, const Class& c );
+
+/**
+ * Resolve where the given class's accessors are defined
+ */
+AccessorDefinition resolveClassAccessors( const Package& p, const Class& c );
+
+/**
+ * Resolve where the given class's strings and blobs allocate
+ */
+AllocatorKind resolveClassAllocator( const Package& p, const Class& c );
+
+/**
+ * Resolve how the given class's serialization functions are called
+ */
+SerializationDispatch resolveClassDispatch( const Package& p, const Class& c );
+
+/**
+ * Resolve how the given integer field is written on the wire
+ */
+IntegerEncoding resolveFieldEncoding( const Class& c, const Field& f );
+
+/**
+ * Resolve the effective settings (privacy, serializable, etc.) of every class and field in the 
+ * package, so that generators can read them directly rather than resolving them over and over. This
+ * throws if the settings are inconsistent.
+ */
+void resolvePackage( Package& p );
+
 };
 
 #endif
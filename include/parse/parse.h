@@ -2,6 +2,8 @@
 #define __CR_PARSE_H_
 
 #include <memory>
+#include <list>
+#include <vector>
 
 #include "core/exception.h"
 #include "tinyxml2.h"
@@ -10,6 +12,8 @@
 
 using namespace tinyxml2;
 using std::shared_ptr;
+using std::list;
+using std::vector;
 
 namespace cr {
 
@@ -18,6 +22,22 @@ namespace cr {
  */
 shared_ptr<GenConfig> parseXML( const char* filename );
 
+/**
+ * Parse a number of XML documents, using up to the given number of worker threads. The returned
+ * configs are in the same order as the files.
+ */
+vector<shared_ptr<GenConfig>> parseAll( const list<File>& files, i32 jobs );
+
+/**
+ * Expand an input path into the XML files it names, appending them to files:
+ *
+ * - a directory is searched (recursively) for *.cr.xml files
+ * - "@path" names a manifest file which lists one input path per line (blank lines and lines
+ *   starting with # are ignored)
+ * - anything else is taken to be an XML file
+ */
+void collectInputFiles( const string& path, list<File>& files );
+
 /**
  * Parse a class XML element
  */
@@ -0,0 +1,56 @@
+#ifndef __CR_SCHEMA_CACHE_H_
+#define __CR_SCHEMA_CACHE_H_
+
+#include <string>
+
+#include "core/types.h"
+#include "core/file.h"
+
+#include "meta.h"
+
+using std::string;
+
+namespace cr {
+
+/**
+ * The schema cache holds a compact binary copy of each input's parsed and resolved GenConfig, so
+ * that later runs can skip XML parsing entirely when the input hasn't changed. Each input gets its
+ * own cache file, which is keyed by a hash of the XML content and of the coderoller build.
+ *
+ * Cache files are only meant to be read by the build that wrote them: they use the host's byte
+ * order, and a different coderoller build never matches their key.
+ */
+
+/**
+ * Returns the cache file for the given input within the given cache dir.
+ */
+File getSchemaCacheFile( const File& cacheDir, const File& inputFile );
+
+/**
+ * Compute the cache key for the given XML content. This build of coderoller (see getBuildHash()) is
+ * part of the key, so a rebuilt parser never loads what an earlier build parsed and resolved.
+ */
+ui64 computeSchemaCacheKey( const char* xml, size_t size );
+
+/**
+ * Load a config from the given cache file (with a single mmap). Returns false, leaving the config's
+ * package and languages alone, if the cache doesn't exist, is for a different key or is damaged.
+ */
+bool loadSchemaCache( const File& cacheFile, ui64 key, GenConfig& config );
+
+/**
+ * Write the config's package and languages to the given cache file. The file is replaced
+ * atomically, so a concurrent reader never sees a partially written cache.
+ */
+void saveSchemaCache( const File& cacheFile, ui64 key, const GenConfig& config );
+
+/**
+ * Append the binary encoding of a class (as stored in the cache) to out. The encoding covers every
+ * parsed and resolved setting of the class and its fields, so it also serves as the basis of the
+ * class fingerprint.
+ */
+void encodeClass( string& out, const Class& c );
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef __CR_STATS_REPORT_H_
+#define __CR_STATS_REPORT_H_
+
+#include <string>
+
+#include "core/types.h"
+
+#include "gen_stats.h"
+
+using std::string;
+
+namespace cr {
+
+/**
+ * Machine readable stats report formats
+ */
+enum class StatsFormat {
+	NONE,
+	JSON,
+	CSV
+};
+
+/**
+ * Convert a string ("json" or "csv") to a StatsFormat. Throws if it is not recognized.
+ */
+StatsFormat toStatsFormat( const char* str );
+
+/**
+ * Format the stats of a run: phase times, peak memory and, for each class, its generation time
+ * and the size of each file it generated, and whether that file was written or up to date.
+ *
+ * JSON is a single object with the run totals and a "classes" array. CSV has one row per phase,
+ * per class and per file, distinguished by the first ("record") column.
+ */
+string formatStatsReport(
+		StatsFormat format,
+		ui64 parseTimeNanos,
+		ui64 genTimeNanos,
+		size_t inputFiles,
+		const GenStats& stats );
+
+}
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef __CR_WATCH_H_
+#define __CR_WATCH_H_
+
+#include <memory>
+#include <vector>
+
+#include "gen_stats.h"
+#include "meta.h"
+
+using std::shared_ptr;
+using std::vector;
+
+namespace cr {
+
+/**
+ * Watch the input files of the given (already generated) configs and regenerate whenever one of them
+ * changes. Only the changed file is re-parsed, and only its changed classes are regenerated, along
+ * with any classes that depend on them through object fields. The configs are updated in place.
+ *
+ * A failed parse or regeneration is logged, and watching goes on. stats are those of the initial
+ * generation; the depfile and manifest (if any) are rewritten after each regeneration, so that they
+ * keep listing every output.
+ *
+ * This only returns by throwing.
+ */
+void watchAndRegenerate( vector<shared_ptr<GenConfig>>& configs, const GenStats& stats );
+
+}
+
+#endif
@@ -1,5 +1,6 @@
 #include "base/stream_roller.h"
 
+#include "base/little_endian.h"
 #include "cr_constants.h"
 
 using std::vector;
@@ -24,8 +25,8 @@ vector<pair<i32, i64>> listStreamContents( void* pointer ) {
 		throw CRException( "Stream is of a different version" );
 	}
 
-	ui32* numberAddress = (ui32*)(buffer + 14);
-	ui32 numberOfObjects = *numberAddress;
+	ui32 numberOfObjects;
+	LittleEndian::read( buffer + 14, &numberOfObjects );
 
 	i64 objectOffset = 18;
 	
@@ -33,11 +34,11 @@ vector<pair<i32, i64>> listStreamContents( void* pointer ) {
 	objects.reserve( numberOfObjects );
 	for ( ui32 i=0; i<numberOfObjects; i++ ) {
 
-		i64* objectSizeAddress = (i64*)(buffer + objectOffset);
-		i64 objectSize = *objectSizeAddress;
+		i64 objectSize;
+		LittleEndian::read( buffer + objectOffset, &objectSize );
 
-		i32* objectDefinitionHashAddress = (i32*)(buffer + objectOffset + sizeof(i64));
-		i32 objectDefinitionHash = *objectDefinitionHashAddress;
+		i32 objectDefinitionHash;
+		LittleEndian::read( buffer + objectOffset + sizeof(i64), &objectDefinitionHash );
 
 		objects.push_back( pair<i32, i64>( objectDefinitionHash, objectOffset + sizeof(i64) + sizeof(i32) ));
 
@@ -51,6 +52,69 @@ vector<pair<i32, i64>> listStreamContents( void* pointer ) {
 	return objects;
 }
 
+// listStreamContents
+i64 listStreamContents( const void* pointer, i64 size, vector<pair<i32, i64>>& contents ) {
+	const ui8* buffer = (const ui8*)pointer;
+
+	contents.clear();
+
+	// the header and the end designation
+	if ( size < 18 + 2 ) {
+		return -1;
+	}
+
+	if ( buffer[0] != 0x73 || buffer[1] != 0x72 ) {
+		return -1;
+	}
+
+	if ( (buffer[3] != (ui8)CR_MAJOR_VERSION)
+			|| (buffer[4] != (ui8)CR_MINOR_VERSION)
+			|| (buffer[5] != (ui8)CR_PATCH_VERSION) ) {
+
+		return -1;
+	}
+
+	ui32 numberOfObjects;
+	LittleEndian::read( buffer + 14, &numberOfObjects );
+
+	// every object takes at least its size and hash, which bounds the count before reserving for it
+	i64 objectOffset = 18;
+	if ( numberOfObjects > (size - objectOffset - 2) / (i64)(sizeof(i64) + sizeof(i32)) ) {
+		return -1;
+	}
+
+	contents.reserve( numberOfObjects );
+	for ( ui32 i=0; i<numberOfObjects; i++ ) {
+
+		if ( objectOffset + (i64)(sizeof(i64) + sizeof(i32)) > size - 2 ) {
+			contents.clear();
+			return -1;
+		}
+
+		i64 objectSize;
+		LittleEndian::read( buffer + objectOffset, &objectSize );
+
+		i32 objectDefinitionHash;
+		LittleEndian::read( buffer + objectOffset + sizeof(i64), &objectDefinitionHash );
+
+		objectOffset += sizeof(i64) + sizeof(i32);
+		if ( objectSize < 0 || objectSize > size - 2 - objectOffset ) {
+			contents.clear();
+			return -1;
+		}
+
+		contents.push_back( pair<i32, i64>( objectDefinitionHash, objectOffset ));
+		objectOffset += objectSize;
+	}
+
+	if ( buffer[objectOffset] != 0x73 || buffer[objectOffset + 1] != 0x72 ) {
+		contents.clear();
+		return -1;
+	}
+
+	return objectOffset + 2;
+}
+
 // createStream
 pair<i64, unique_ptr<ui8[]>> createStreamContents( const list<const Serializable*> objects ) {
 
@@ -85,8 +149,7 @@ pair<i64, unique_ptr<ui8[]>> createStreamContents( const list<const Serializable
 	// byte[6 - 13]
 
 	// number of objects
-	ui32* numberAddress = (ui32*)(pointer + 14);
-	*numberAddress = objects.size();
+	LittleEndian::write( pointer + 14, (ui32)objects.size() );
 
 	i64 objectOffset = 18;
 
@@ -95,11 +158,8 @@ pair<i64, unique_ptr<ui8[]>> createStreamContents( const list<const Serializable
 		i64 objectSize = object->getSerializedSize();
 		i32 objectDefinitionHash = object->getClassHash();
 
-		i64* objectSizeAddress = (i64*)(pointer + objectOffset);
-		*objectSizeAddress = objectSize;
-
-		i32* objectDefinitionHashAddress = (i32*)(pointer + objectOffset + sizeof(i64));
-		*objectDefinitionHashAddress = objectDefinitionHash;
+		LittleEndian::write( pointer + objectOffset, objectSize );
+		LittleEndian::write( pointer + objectOffset + sizeof(i64), objectDefinitionHash );
 
 		i64 written = object->serialize( (void*)(pointer + objectOffset + sizeof(i64) + sizeof(i32)) );
 
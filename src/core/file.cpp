@@ -2,6 +2,7 @@
 #define FILE_CPP_INCLUDED
 
 #include <string>
+#include <stdio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <errno.h>
@@ -289,6 +290,75 @@ ui64 File::getSize() const {
 	return fileStats.st_size;
 }
 
+// readContents
+bool File::readContents( string& contents ) const {
+
+	FILE* in = fopen( _path.c_str(), "rb" );
+	if ( ! in ) {
+		return false;
+	}
+
+	struct stat fileStats;
+	if ( 0 != fstat( fileno( in ), &fileStats )) {
+		fclose( in );
+		return false;
+	}
+
+	contents.resize( fileStats.st_size );
+	size_t read = fread( &contents[0], 1, contents.size(), in );
+	fclose( in );
+
+	return read == contents.size();
+}
+
+// writeIfChanged
+bool File::writeIfChanged( const string& contents ) const {
+
+	struct stat fileStats;
+	if ( 0 == stat( _path.c_str(), &fileStats ) && (ui64)fileStats.st_size == contents.size() ) {
+
+		FILE* in = fopen( _path.c_str(), "rb" );
+		if ( in ) {
+
+			// compare in chunks so we never hold a second copy of the file
+			char buffer[16384];
+			size_t offset = 0;
+			bool same = true;
+			while ( same && offset < contents.size() ) {
+				size_t read = fread( buffer, 1, sizeof( buffer ), in );
+				if ( read == 0 ) {
+					same = false;
+				} else {
+					same = (0 == memcmp( buffer, contents.data() + offset, read ));
+					offset += read;
+				}
+			}
+			fclose( in );
+
+			if ( same ) {
+				return false;
+			}
+		}
+	}
+
+	FILE* out = fopen( _path.c_str(), "wb" );
+	if ( ! out ) {
+		throw CRException( "Error(%d) while trying to open %s for writing: %s",
+				errno,
+				_path.c_str(),
+				strerror(errno) );
+	}
+
+	size_t written = fwrite( contents.data(), 1, contents.size(), out );
+	fclose( out );
+
+	if ( written != contents.size() ) {
+		throw CRException( "Failed to write %s", _path.c_str() );
+	}
+
+	return true;
+}
+
 // refresh
 void File::refresh() {
 	initialize();
@@ -315,7 +385,9 @@ list<File> File::listFiles() {
 
 		dirp = readdir( dp );
 		while ( dirp != NULL ) {
-			files.push_back( File( dirp->d_name ));
+			if ( strcmp( dirp->d_name, "." ) != 0 && strcmp( dirp->d_name, ".." ) != 0 ) {
+				files.push_back( File( *this, dirp->d_name ));
+			}
 			dirp = readdir( dp );
 		}
 
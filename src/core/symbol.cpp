@@ -0,0 +1,45 @@
+#include "core/symbol.h"
+
+#include <mutex>
+#include <unordered_set>
+
+namespace cr {
+
+/**
+ * Intern a string. Nodes in an unordered_set are never moved, so pointers to its strings stay valid as
+ * it grows. The table is deliberately leaked so that symbols held by other static objects stay valid
+ * during shutdown.
+ */
+static const string* intern( const string& str ) {
+
+	static std::mutex* s_mutex = new std::mutex();
+	static std::unordered_set<string>* s_table = new std::unordered_set<string>();
+
+	std::lock_guard<std::mutex> lock( *s_mutex );
+	return &*s_table->insert( str ).first;
+}
+
+/**
+ * Returns the empty symbol's string (without taking the lock every time)
+ */
+static const string* getEmpty() {
+	static const string* s_empty = intern( string() );
+	return s_empty;
+}
+
+// Constructor
+Symbol::Symbol() :
+				_str(getEmpty()) {
+}
+
+// Constructor
+Symbol::Symbol( const string& str ) :
+				_str(str.empty() ? getEmpty() : intern( str )) {
+}
+
+// Constructor
+Symbol::Symbol( const char* str ) :
+				_str((str == nullptr || *str == 0x00) ? getEmpty() : intern( string( str ))) {
+}
+
+} // namespace cr
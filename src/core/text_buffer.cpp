@@ -0,0 +1,216 @@
+#include "core/text_buffer.h"
+
+#include <algorithm>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "core/exception.h"
+
+#define HASH_MULTIPLIER 37
+
+namespace cr {
+
+// Constructor
+TextBuffer::TextBuffer( size_t chunkSize ) :
+				_chunkSize(chunkSize),
+				_size(0),
+				_hashing(false),
+				_hash(0) {
+}
+
+// append
+TextBuffer& TextBuffer::append( const char* data, size_t length ) {
+
+	// same as hash() in cr_util, one byte at a time
+	if ( _hashing ) {
+		for ( size_t i = 0; i < length; i++ ) {
+			_hash = HASH_MULTIPLIER * _hash + data[i];
+		}
+	}
+
+	while ( length > 0 ) {
+
+		size_t used = _size % _chunkSize;
+		if ( _size == _chunks.size() * _chunkSize ) {
+			_chunks.push_back( unique_ptr<char[]>( new char[_chunkSize] ));
+		}
+
+		size_t count = std::min( length, _chunkSize - used );
+		memcpy( _chunks.back().get() + used, data, count );
+
+		_size += count;
+		data += count;
+		length -= count;
+	}
+
+	return *this;
+}
+
+// append
+TextBuffer& TextBuffer::append( const TextBuffer& other, size_t begin, size_t end ) {
+
+	while ( begin < end ) {
+		size_t offset = begin % other._chunkSize;
+		size_t count = std::min( end - begin, other._chunkSize - offset );
+		append( other._chunks[begin / other._chunkSize].get() + offset, count );
+		begin += count;
+	}
+
+	return *this;
+}
+
+// operator<<
+TextBuffer& TextBuffer::operator<<( const char* str ) {
+	return append( str, strlen( str ));
+}
+
+// appendSigned
+TextBuffer& TextBuffer::appendSigned( i64 value ) {
+	char buffer[24];
+	i32 length = snprintf( buffer, sizeof( buffer ), "%lld", value );
+	return append( buffer, length );
+}
+
+// appendUnsigned
+TextBuffer& TextBuffer::appendUnsigned( ui64 value ) {
+	char buffer[24];
+	i32 length = snprintf( buffer, sizeof( buffer ), "%llu", value );
+	return append( buffer, length );
+}
+
+// startHash
+void TextBuffer::startHash() {
+	_hashing = true;
+	_hash = 0;
+}
+
+// patch
+void TextBuffer::patch( size_t offset, const char* data, size_t length ) {
+
+	if ( offset + length > _size ) {
+		throw CRException( "Patch (%lu bytes at %lu) is out of bounds", length, offset );
+	}
+
+	while ( length > 0 ) {
+		size_t chunkOffset = offset % _chunkSize;
+		size_t count = std::min( length, _chunkSize - chunkOffset );
+		memcpy( _chunks[offset / _chunkSize].get() + chunkOffset, data, count );
+
+		offset += count;
+		data += count;
+		length -= count;
+	}
+}
+
+// str
+string TextBuffer::str() const {
+
+	string contents;
+	contents.reserve( _size );
+	for ( size_t offset = 0; offset < _size; offset += _chunkSize ) {
+		contents.append( _chunks[offset / _chunkSize].get(), std::min( _chunkSize, _size - offset ));
+	}
+
+	return contents;
+}
+
+// matchesFile
+bool TextBuffer::matchesFile( const string& path ) const {
+
+	i32 fd = open( path.c_str(), O_RDONLY );
+	if ( fd < 0 ) {
+		return false;
+	}
+
+	struct stat fileStats;
+	bool same = (0 == fstat( fd, &fileStats ) && (size_t)fileStats.st_size == _size);
+
+	// compare one chunk at a time
+	unique_ptr<char[]> buffer;
+	if ( same && _size > 0 ) {
+		buffer.reset( new char[_chunkSize] );
+	}
+
+	for ( size_t offset = 0; same && offset < _size; offset += _chunkSize ) {
+
+		size_t length = std::min( _chunkSize, _size - offset );
+		size_t read = 0;
+		while ( read < length ) {
+			ssize_t count = ::read( fd, buffer.get() + read, length - read );
+			if ( count <= 0 ) {
+				break;
+			}
+			read += count;
+		}
+
+		same = (read == length && 0 == memcmp( buffer.get(), _chunks[offset / _chunkSize].get(), length ));
+	}
+
+	close( fd );
+
+	return same;
+}
+
+// writeTo
+bool TextBuffer::writeTo( const File& file ) const {
+
+	const string& path = file.getFullPath();
+
+	if ( matchesFile( path )) {
+		return false;
+	}
+
+	i32 fd = open( path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if ( fd < 0 ) {
+		throw CRException( "Error(%d) while trying to open %s for writing: %s",
+				errno,
+				path.c_str(),
+				strerror(errno) );
+	}
+
+	// hand every chunk to the kernel at once (in batches of IOV_MAX, for huge buffers)
+	vector<struct iovec> chunks;
+	chunks.reserve( _chunks.size() );
+	for ( size_t offset = 0; offset < _size; offset += _chunkSize ) {
+		struct iovec chunk;
+		chunk.iov_base = _chunks[offset / _chunkSize].get();
+		chunk.iov_len = std::min( _chunkSize, _size - offset );
+		chunks.push_back( chunk );
+	}
+
+	size_t next = 0;
+	while ( next < chunks.size() ) {
+
+		i32 count = (i32)std::min( chunks.size() - next, (size_t)IOV_MAX );
+		ssize_t written = writev( fd, &chunks[next], count );
+		if ( written < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			close( fd );
+			throw CRException( "Error(%d) while writing %s: %s", errno, path.c_str(), strerror(errno) );
+		}
+
+		// skip what was written; a short write leaves a partial chunk at the front
+		while ( next < chunks.size() && (size_t)written >= chunks[next].iov_len ) {
+			written -= chunks[next].iov_len;
+			next++;
+		}
+		if ( written > 0 ) {
+			chunks[next].iov_base = (char*)chunks[next].iov_base + written;
+			chunks[next].iov_len -= written;
+		}
+	}
+
+	close( fd );
+
+	return true;
+}
+
+} // namespace cr
@@ -10,8 +10,18 @@ using std::dynamic_pointer_cast;
 
 namespace cr {
 
-File g_inputFile;
+list<File> g_inputFiles;
 File g_outputDir;
+i32 g_jobs = 1;
+bool g_deterministic = false;
+bool g_watch = false;
+File g_depfile;
+File g_outputManifest;
+File g_schemaCacheDir;
+StatsFormat g_statsFormat = StatsFormat::NONE;
+File g_statsFile;
+UnityOutput g_unityOutput = UnityOutput::NONE;
+i32 g_unityShards = 0;
 
 map<Language, shared_ptr<CodeGenerator>> g_codeGenerators;
 
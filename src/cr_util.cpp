@@ -1,6 +1,15 @@
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/resource.h>
+#include <atomic>
 #include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
 
+#include "core/file.h"
 #include "core/log.h"
 #include "core/types.h"
 
@@ -105,20 +114,178 @@ AccessPrivacy toAccessPrivacy( const char* str ) {
 SerializableSpecification toSerializableSpecification( const char* str ) {
 	if ( str == nullptr || str[0] == 0x00 ) {
 		return SerializableSpecification::NONE;
-	} else if ( (strcmp( str, "yes" ) == 0 ) || (strcmp( str, "true" )) ) {
+	} else if ( (strcmp( str, "yes" ) == 0 ) || (strcmp( str, "true" ) == 0) ) {
 		return SerializableSpecification::YES;
-	} else if ( (strcmp( str, "no" ) == 0 ) || (strcmp( str, "false" )) ) {
+	} else if ( (strcmp( str, "no" ) == 0 ) || (strcmp( str, "false" ) == 0) ) {
 		return SerializableSpecification::NO;
 	} else {
 		return SerializableSpecification::NONE;
 	}
 }
 
+// toFieldLayout
+FieldLayout toFieldLayout( const char* str ) {
+
+	if ( nullptr == str || strcmp( str, "" ) == 0 ) {
+		return FieldLayout::NONE;
+
+	} else if ( strcmp( str, "declaration" ) == 0 ) {
+		return FieldLayout::DECLARATION;
+
+	} else if ( strcmp( str, "compact" ) == 0 ) {
+		return FieldLayout::COMPACT;
+
+	} else {
+		throw CRException( "Unrecognized layout: %s", str );
+	}
+}
+
+// toAccessorDefinition
+AccessorDefinition toAccessorDefinition( const char* str ) {
+
+	if ( nullptr == str || strcmp( str, "" ) == 0 ) {
+		return AccessorDefinition::NONE;
+
+	} else if ( strcmp( str, "outOfLine" ) == 0 ) {
+		return AccessorDefinition::OUT_OF_LINE;
+
+	} else if ( strcmp( str, "inline" ) == 0 ) {
+		return AccessorDefinition::INLINE;
+
+	} else {
+		throw CRException( "Unrecognized accessors: %s", str );
+	}
+}
+
+// toAllocatorKind
+AllocatorKind toAllocatorKind( const char* str ) {
+
+	if ( nullptr == str || strcmp( str, "" ) == 0 ) {
+		return AllocatorKind::NONE;
+
+	} else if ( strcmp( str, "default" ) == 0 ) {
+		return AllocatorKind::DEFAULT;
+
+	} else if ( strcmp( str, "pmr" ) == 0 ) {
+		return AllocatorKind::PMR;
+
+	} else {
+		throw CRException( "Unrecognized allocator: %s", str );
+	}
+}
+
+// toSerializationDispatch
+SerializationDispatch toSerializationDispatch( const char* str ) {
+
+	if ( nullptr == str || strcmp( str, "" ) == 0 ) {
+		return SerializationDispatch::NONE;
+
+	} else if ( strcmp( str, "virtual" ) == 0 ) {
+		return SerializationDispatch::VIRTUAL;
+
+	} else if ( strcmp( str, "static" ) == 0 ) {
+		return SerializationDispatch::STATIC;
+
+	} else {
+		throw CRException( "Unrecognized dispatch: %s", str );
+	}
+}
+
+// toIntegerEncoding
+IntegerEncoding toIntegerEncoding( const char* str ) {
+
+	if ( nullptr == str || strcmp( str, "" ) == 0 ) {
+		return IntegerEncoding::NONE;
+
+	} else if ( strcmp( str, "fixed" ) == 0 ) {
+		return IntegerEncoding::FIXED;
+
+	} else if ( strcmp( str, "varint" ) == 0 ) {
+		return IntegerEncoding::VARINT;
+
+	} else {
+		throw CRException( "Unrecognized encoding: %s", str );
+	}
+}
+
+// isInteger
+bool isInteger( DataType type ) {
+	return type >= DataType::I8 && type <= DataType::UI64;
+}
+
+// isSignedInteger
+bool isSignedInteger( DataType type ) {
+	return type == DataType::I8 || type == DataType::I16 || type == DataType::I32 || type == DataType::I64;
+}
+
+// toBoolean
+bool toBoolean( const char* str, bool defaultValue ) {
+
+	if ( nullptr == str || strcmp( str, "" ) == 0 ) {
+		return defaultValue;
+
+	} else if ( strcmp( str, "true" ) == 0 || strcmp( str, "yes" ) == 0 ) {
+		return true;
+
+	} else if ( strcmp( str, "false" ) == 0 || strcmp( str, "no" ) == 0 ) {
+		return false;
+
+	} else {
+		throw CRException( "Unrecognized boolean: %s", str );
+	}
+}
+
+// toPositiveInteger
+ui32 toPositiveInteger( const char* str, ui32 defaultValue ) {
+
+	if ( nullptr == str || strcmp( str, "" ) == 0 ) {
+		return defaultValue;
+	}
+
+	char* end = nullptr;
+	errno = 0;
+	unsigned long value = strtoul( str, &end, 10 );
+	if ( *str < '0' || *str > '9' || *end != '\0' || errno != 0 || value == 0 || value > 0xffffffffUL ) {
+		throw CRException( "Unrecognized positive integer: %s", str );
+	}
+	return (ui32)value;
+}
+
 // capitalize
 char capitalize( char c ) {
 	return c - (97 - 65);
 }
 
+// hash64
+ui64 hash64( const void* data, size_t size, ui64 h ) {
+	const ui8* bytes = (const ui8*)data;
+	for ( size_t i = 0; i < size; i++ ) {
+		h ^= bytes[i];
+		h *= 0x100000001b3ULL;
+	}
+	return h;
+}
+
+// hash64
+ui64 hash64( const string& str, ui64 h ) {
+	return hash64( str.c_str(), str.size() + 1, h );
+}
+
+// getBuildHash
+ui64 getBuildHash() {
+	static const ui64 buildHash = []() {
+		ui64 h = hash64( GIT_HASH, sizeof( GIT_HASH ));
+		string executable;
+		if ( File( "/proc/self/exe" ).readContents( executable )) {
+			h = hash64( executable.data(), executable.size(), h );
+		} else {
+			Log::w( "Failed to read the coderoller executable; rebuilds will only be told apart by git hash" );
+		}
+		return h;
+	}();
+	return buildHash;
+}
+
 // getTimeMillis
 ui64 getTimeMillis() {
 	// here's a taste of the T in STL...
@@ -126,4 +293,75 @@ ui64 getTimeMillis() {
 	return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
 }
 
+// getPeakMemoryBytes
+ui64 getPeakMemoryBytes() {
+	struct rusage usage;
+	if ( getrusage( RUSAGE_SELF, &usage ) != 0 ) {
+		return 0;
+	}
+	return (ui64)usage.ru_maxrss * 1024; // kilobytes on linux
+}
+
+// getCoreCount
+i32 getCoreCount() {
+	i32 cores = (i32)std::thread::hardware_concurrency();
+	return (cores > 0) ? cores : 1;
+}
+
+// parallelFor
+void parallelFor( size_t count, i32 jobs, const std::function<void(size_t)>& fn ) {
+
+	if ( jobs > (i32)count ) {
+		jobs = (i32)count;
+	}
+
+	// not worth spinning up threads
+	if ( jobs <= 1 ) {
+		for ( size_t i = 0; i < count; i++ ) {
+			fn( i );
+		}
+		return;
+	}
+
+	std::atomic<size_t> next( 0 );
+	std::atomic<bool> failed( false );
+	std::exception_ptr firstError;
+	std::mutex errorMutex;
+
+	auto worker = [&]() {
+		while ( ! failed ) {
+			size_t i = next++;
+			if ( i >= count ) {
+				return;
+			}
+
+			try {
+				fn( i );
+			} catch ( ... ) {
+				std::lock_guard<std::mutex> lock( errorMutex );
+				if ( ! firstError ) {
+					firstError = std::current_exception();
+				}
+				failed = true;
+			}
+		}
+	};
+
+	// the calling thread does its share of the work, too
+	std::vector<std::thread> threads;
+	threads.reserve( jobs - 1 );
+	for ( i32 i = 1; i < jobs; i++ ) {
+		threads.push_back( std::thread( worker ));
+	}
+	worker();
+
+	for ( std::thread& thread : threads ) {
+		thread.join();
+	}
+
+	if ( firstError ) {
+		std::rethrow_exception( firstError );
+	}
+}
+
 };
@@ -0,0 +1,61 @@
+#include "depfile.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sstream>
+
+#include "core/exception.h"
+
+using std::ostringstream;
+
+namespace cr {
+
+/**
+ * Escape a path for use in a depfile (spaces, # and $ are special to Make and Ninja)
+ */
+static void writeDepfilePath( ostringstream& stream, const string& path ) {
+	for ( char c : path ) {
+		if ( c == ' ' || c == '#' || c == '\\' ) {
+			stream << '\\';
+		} else if ( c == '$' ) {
+			stream << '$';
+		}
+		stream << c;
+	}
+}
+
+// writeDepfile
+void writeDepfile( const File& file, const GenStats& stats ) {
+
+	ostringstream stream;
+	for ( const ClassGenStats& classStats : stats._classes ) {
+
+		for ( size_t i = 0; i < classStats._outputs.size(); i++ ) {
+			if ( i > 0 ) {
+				stream << ' ';
+			}
+			writeDepfilePath( stream, classStats._outputs[i]._path );
+		}
+
+		stream << ": ";
+		writeDepfilePath( stream, classStats._inputFile );
+		stream << '\n';
+	}
+
+	file.writeIfChanged( stream.str() );
+}
+
+// writeOutputManifest
+void writeOutputManifest( const File& file, const GenStats& stats ) {
+
+	ostringstream stream;
+	for ( const ClassGenStats& classStats : stats._classes ) {
+		for ( const OutputFileStats& output : classStats._outputs ) {
+			stream << output._path << '\t' << classStats._inputFile << '\n';
+		}
+	}
+
+	file.writeIfChanged( stream.str() );
+}
+
+}
@@ -0,0 +1,86 @@
+#include "fingerprint_store.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/log.h"
+#include "core/exception.h"
+
+namespace cr {
+
+// Constructor
+FingerprintStore::FingerprintStore() :
+				_dirty(false) {
+}
+
+// load
+void FingerprintStore::load( const File& file ) {
+
+	_file = file;
+	_fingerprints.clear();
+	_dirty = false;
+
+	FILE* in = fopen( file.getFullPath().c_str(), "r" );
+	if ( ! in ) {
+		return;
+	}
+
+	char line[1024];
+	while ( fgets( line, sizeof( line ), in )) {
+
+		char* separator = strrchr( line, ' ' );
+		if ( ! separator ) {
+			continue;
+		}
+		*separator = 0x00;
+
+		_fingerprints[line] = strtoull( separator + 1, nullptr, 16 );
+	}
+
+	fclose( in );
+}
+
+// save
+void FingerprintStore::save() {
+
+	if ( ! _dirty ) {
+		return;
+	}
+
+	FILE* out = fopen( _file.getFullPath().c_str(), "w" );
+	if ( ! out ) {
+		throw CRException( "Failed to write fingerprints to %s", _file.getFullPath().c_str() );
+	}
+
+	for ( auto& entry : _fingerprints ) {
+		fprintf( out, "%s %016llx\n", entry.first.c_str(), entry.second );
+	}
+
+	fclose( out );
+	_dirty = false;
+}
+
+// matches
+bool FingerprintStore::matches( const string& key, ui64 fingerprint ) const {
+	auto itr = _fingerprints.find( key );
+	return (itr != _fingerprints.end() && itr->second == fingerprint);
+}
+
+// set
+void FingerprintStore::set( const string& key, ui64 fingerprint ) {
+	auto itr = _fingerprints.find( key );
+	if ( itr == _fingerprints.end() || itr->second != fingerprint ) {
+		_fingerprints[key] = fingerprint;
+		_dirty = true;
+	}
+}
+
+// erase
+void FingerprintStore::erase( const string& key ) {
+	if ( _fingerprints.erase( key ) > 0 ) {
+		_dirty = true;
+	}
+}
+
+};
@@ -13,17 +13,37 @@ using namespace tinyxml2;
 namespace cr {
 
 // generateAll
-void generateAll( shared_ptr<GenConfig> config ) {
+void generateAll( shared_ptr<GenConfig> config, GenStats& stats ) {
+	generateAll( vector<shared_ptr<GenConfig>>( 1, config ), stats );
+}
+
+// generateAll
+void generateAll( const vector<shared_ptr<GenConfig>>& configs, GenStats& stats ) {
 
-	for ( Language language : config->_languages ) {
-		shared_ptr<CodeGenerator> generator = g_codeGenerators[language];
+	// group configs by language, keeping their order
+	map<Language, vector<shared_ptr<GenConfig>>> configsByLanguage;
+	for ( const shared_ptr<GenConfig>& config : configs ) {
+		for ( Language language : config->_languages ) {
+			configsByLanguage[language].push_back( config );
+		}
+	}
+
+	for ( auto& entry : configsByLanguage ) {
+		shared_ptr<CodeGenerator> generator = g_codeGenerators[entry.first];
 		if ( ! generator ) {
 			throw CRException( "No known generator for language" );
 		}
 
-		generator->generate( config );
+		generator->generate( entry.second, stats );
 	}
 
 };
 
+// invalidateAll
+void invalidateAll( const string& className ) {
+	for ( auto& entry : g_codeGenerators ) {
+		entry.second->invalidate( className );
+	}
+}
+
 }
@@ -1,28 +1,390 @@
 #include "languages/cpp/cpp_class_generator.h"
 
+#include <chrono>
 #include <memory>
-#include <iostream>
-#include <fstream>
-#include <ios>
 #include <set>
+#include <stdio.h>
 
 #include "languages/cpp/cpp_util.h"
 #include "cr_constants.h"
+#include "cr_globals.h"
 #include "cr_util.h"
 #include "core/log.h"
 
 using std::set;
 using std::unique_ptr;
 using std::shared_ptr;
-using std::ostream;
-using std::ofstream;
-using std::ostringstream;
-using std::endl;
 
 namespace cr {
 
+/**
+ * Call fn for each serialized field, in wire order
+ */
+template<typename FN>
+static void forEachSerializedField( const Class& c, FN fn ) {
+	forEachField( c, [&fn]( const Field& f ) {
+		if ( f._serialized ) {
+			fn( f );
+		}
+	} );
+}
+
+/**
+ * Returns the expression a const member function uses to read the given field
+ */
+static string getReadExpression( const Field& f ) {
+	return (f._cold ? "getCold()._" : "_") + f._name.str();
+}
+
+/**
+ * Returns the expression a member function uses to modify the given field (cold fields are allocated
+ * on demand)
+ */
+static string getWriteExpression( const Field& f ) {
+	return (f._cold ? "mutableCold()._" : "_") + f._name.str();
+}
+
+/**
+ * Returns true if the field holds a primitive (not a string, blob or object)
+ */
+static bool isPrimitive( const Field& f ) {
+	return f._dataType != DataType::STRING && f._dataType != DataType::BLOB && f._dataType != DataType::OBJECT;
+}
+
+/**
+ * Returns true if the field is a blob held in a ByteArray (rather than a std::pmr::vector)
+ */
+static bool isByteArray( const Field& f ) {
+	return f._dataType == DataType::BLOB && ! f._pmr;
+}
+
+/**
+ * Returns true if the field is a string, or a blob held in a std::pmr::vector, which is written as
+ * its (little endian) length and then its bytes. ByteArrays are left to Serialization.
+ */
+static bool isSerializedAsBytes( const Field& f ) {
+	return f._dataType == DataType::STRING || f._pmr;
+}
+
+/**
+ * Returns the vector type holding the class's columns
+ */
+static const char* getColumnVectorName( const Class& c ) {
+	return c._pmr ? "std::pmr::vector" : "std::vector";
+}
+
+/**
+ * Returns the fields stored in the class itself (not cold or packed), in the order they are declared
+ */
+static vector<const Field*> getStoredFields( const Class& c ) {
+
+	if ( c._compactLayout ) {
+		return computeClassLayout( c, true )._fields;
+	}
+
+	vector<const Field*> fields;
+	for ( AccessPrivacy privacy : { AccessPrivacy::PUBLIC, AccessPrivacy::PROTECTED, AccessPrivacy::PRIVATE } ) {
+		for ( const Field& f : c._fields ) {
+			if ( f._privacy == privacy && ! f._cold && f._bitIndex < 0 ) {
+				fields.push_back( &f );
+			}
+		}
+	}
+	return fields;
+}
+
+/**
+ * Returns true if any field of the class is an object
+ */
+static bool hasObjectFields( const Class& c ) {
+	for ( const Field& f : c._fields ) {
+		if ( f._dataType == DataType::OBJECT ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns true if any field of the class is a blob held in a ByteArray
+ */
+static bool hasByteArrays( const Class& c ) {
+	for ( const Field& f : c._fields ) {
+		if ( isByteArray( f )) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns true if the class only holds primitives (and cr::FixedStrings) and has no virtual
+ * functions, so that it is trivially copyable
+ */
+static bool isTriviallyCopyable( const Class& c ) {
+	if ( (c._serialized && ! c._staticDispatch) || c._hasColdFields ) {
+		return false;
+	}
+	for ( const Field& f : c._fields ) {
+		if ( ! isPrimitive( f ) && ! isFixedString( f )) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Returns true if any serialized field of the class is written as its length and then its bytes
+ */
+static bool hasFieldsSerializedAsBytes( const Class& c ) {
+	for ( const Field& f : c._fields ) {
+		if ( f._serialized && isSerializedAsBytes( f )) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns true if any field of the class is written as a varint
+ */
+static bool hasVarints( const Class& c ) {
+	for ( const Field& f : c._fields ) {
+		if ( f._varint ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns the value Varint::write() takes for the given varint field's value (signed integers are
+ * zigzag encoded)
+ */
+static string getVarintValue( const Field& f, const string& value ) {
+	return isSignedInteger( f._dataType ) ? "Varint::zigzagEncode( " + value + " )" : value;
+}
+
+/**
+ * Returns true if any field of the class is a std::pmr::string
+ */
+static bool hasPmrStrings( const Class& c ) {
+	for ( const Field& f : c._fields ) {
+		if ( f._pmr && f._dataType == DataType::STRING ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns true if any field of the class is a blob held in a std::pmr::vector
+ */
+static bool hasPmrBlobs( const Class& c ) {
+	for ( const Field& f : c._fields ) {
+		if ( f._pmr && f._dataType == DataType::BLOB ) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns true if any field of the class is a string with a maxLength
+ */
+static bool hasFixedStrings( const Class& c ) {
+	for ( const Field& f : c._fields ) {
+		if ( isFixedString( f )) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Returns the element type of the given field's column. Bools are stored as bytes: std::vector<bool>
+ * packs bits, which rules out references to elements and vectorized loops over the column.
+ */
+static string getColumnTypeName( const Field& f ) {
+	return f._dataType == DataType::BOOLEAN ? "uint8_t" : getFieldTypeName( f );
+}
+
+/**
+ * Returns the word holding the given packed bool field
+ */
+static string getPackedBoolWord( const Class& c, const Field& f ) {
+	return getPackedBoolWordName( c, (ui32)f._bitIndex / getPackedBoolWordBits( c ));
+}
+
+/**
+ * Returns a literal of the given bits of a packed bool word
+ */
+static string getPackedBoolLiteral( const Class& c, ui64 bits ) {
+	char literal[32];
+	snprintf( literal, sizeof( literal ), "0x%llx%s", (unsigned long long)bits, getPackedBoolWordBits( c ) == 64 ? "ull" : "" );
+	return literal;
+}
+
+/**
+ * Returns a literal of the mask selecting the given packed bool field within its word
+ */
+static string getPackedBoolMask( const Class& c, const Field& f ) {
+	return getPackedBoolLiteral( c, 1ull << ((ui32)f._bitIndex % getPackedBoolWordBits( c )));
+}
+
+/**
+ * Returns the mask of the serialized bools within the given packed bool word
+ */
+static ui64 getSerializedPackedBoolBits( const Class& c, ui32 word ) {
+
+	ui32 wordBits = getPackedBoolWordBits( c );
+
+	ui64 bits = 0;
+	for ( const Field& f : c._fields ) {
+		if ( f._bitIndex >= 0 && f._serialized && (ui32)f._bitIndex / wordBits == word ) {
+			bits |= 1ull << ((ui32)f._bitIndex % wordBits);
+		}
+	}
+	return bits;
+}
+
+/**
+ * Returns true if every bit of the given mask of a packed bool word is set
+ */
+static bool isFullPackedBoolMask( const Class& c, ui64 bits ) {
+	ui32 wordBits = getPackedBoolWordBits( c );
+	return bits == (wordBits == 64 ? ~0ull : (1ull << wordBits) - 1);
+}
+
+/**
+ * A member of the Wire struct of a class with a fixed size wire format: a serialized field, or a
+ * word of packed bools (along with the mask of its serialized bits)
+ */
+struct WireMember {
+
+	string _name;
+	string _typeName;
+	const Field* _field; // null for a packed bool word
+	ui64 _bits;
+};
+
+/**
+ * Returns the Wire struct members of the given class, in wire order. If any serialized field doesn't
+ * have a fixed width (strings, blobs, objects and varints), returns false instead.
+ */
+static bool getWireMembers( const Class& c, vector<WireMember>& members ) {
+
+	bool fixed = true;
+	bool packedBoolsAdded = false;
+	forEachSerializedField( c, [&c, &members, &fixed, &packedBoolsAdded]( const Field& f ) {
+		if ( getDataTypeSize( f._dataType ) == 0 || f._varint ) {
+			fixed = false;
+		} else if ( f._bitIndex < 0 ) {
+			members.push_back( { "_" + f._name.str(), getDataTypeName( f._dataType ), &f, 0 } );
+		} else if ( ! packedBoolsAdded ) {
+			for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+				ui64 bits = getSerializedPackedBoolBits( c, i );
+				if ( bits != 0 ) {
+					members.push_back( { getPackedBoolWordName( c, i ), getPackedBoolWordType( c ), nullptr, bits } );
+				}
+			}
+			packedBoolsAdded = true;
+		}
+	} );
+	return fixed;
+}
+
+/**
+ * Returns true if every serialized field of the class has a fixed width (primitives and packed bools),
+ * so that its wire format has a fixed size, which is returned in size
+ */
+static bool getFixedSerializedSize( const Class& c, ui64& size ) {
+
+	vector<WireMember> members;
+	// a Wire struct needs at least one member (an empty struct still takes a byte)
+	if ( ! c._serialized || ! getWireMembers( c, members ) || members.empty() ) {
+		return false;
+	}
+
+	size = 0;
+	for ( const WireMember& member : members ) {
+		size += member._field ? getDataTypeSize( member._field->_dataType ) : getPackedBoolWordBits( c ) / 8;
+	}
+	return true;
+}
+
+/**
+ * Returns true if the serialized size of the field depends on its value (strings, blobs, objects and
+ * varints)
+ */
+static bool isVariableSize( const Field& f ) {
+	return ! isPrimitive( f ) || f._varint;
+}
+
+/**
+ * Returns the number of bytes of the given serialized field which the bounds checked internalize
+ * checks ahead of reading them: all of a fixed size field, the length of a string or blob, and
+ * nothing of an object or varint. A packed bool stands for all of the class's packed bool words.
+ */
+static i64 getCheckedFixedSize( const Class& c, const Field& f ) {
+
+	if ( f._bitIndex >= 0 ) {
+		i64 size = 0;
+		for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+			if ( getSerializedPackedBoolBits( c, i ) != 0 ) {
+				size += getPackedBoolWordBits( c ) / 8;
+			}
+		}
+		return size;
+	}
+
+	if ( f._dataType == DataType::STRING || f._dataType == DataType::BLOB ) {
+		return sizeof( i64 );
+	}
+	return isVariableSize( f ) ? 0 : getDataTypeSize( f._dataType );
+}
+
+/**
+ * Returns the number of bytes checked ahead of reading fields[first], counting from it up to and
+ * including the next variable size field
+ */
+static i64 getCheckedRunSize( const Class& c, const vector<const Field*>& fields, size_t first ) {
+	i64 size = 0;
+	for ( size_t i = first; i < fields.size(); i++ ) {
+		size += getCheckedFixedSize( c, *fields[i] );
+		if ( isVariableSize( *fields[i] )) {
+			break;
+		}
+	}
+	return size;
+}
+
+/**
+ * Returns the condition under which a variable size part of the given size, followed by
+ * followingSize checked bytes, doesn't fit in the rest of the buffer
+ */
+static string getBoundsCondition( const string& size, i64 followingSize ) {
+	string condition = size + " > bufferSize - read";
+	if ( followingSize > 0 ) {
+		condition += " - " + std::to_string( followingSize );
+	}
+	return condition;
+}
+
+/**
+ * Returns the condition under which an object or varint which was read within bounds (unless size is
+ * -1) leaves too little of the buffer for the followingSize checked bytes after it
+ */
+static string getReadSizeCondition( i64 followingSize ) {
+	return followingSize > 0 ? "size < 0 || " + getBoundsCondition( "size", followingSize ) : "size < 0";
+}
+
 // Constructor
-CPPClassGenerator::CPPClassGenerator() :
+CPPClassGenerator::CPPClassGenerator( bool keepSource ) :
+				_keepSource(keepSource),
+				_inlineAccessors(false),
+				_coldOutOfLine(false),
+				_inlineSerialization(false),
 				_hashPosition1(-1),
 				_hashPosition2(-1) {
 }
@@ -38,22 +400,18 @@ void CPPClassGenerator::generate(
 			const string& includeRoot,
 			const string& hFilePath, 
 			const string& sourceRoot,
-			const string& cppFilePath ) {
+			const string& cppFilePath,
+			ClassGenStats& stats ) {
 
 	File hFile( config->_outputDir, includeRoot + hFilePath );
 	File cppFile( config->_outputDir, sourceRoot + cppFilePath );
 
-	bool hFileDirty = (! hFile.exists() || (hFile.getMTime() < config->_mTime));
-	bool cppFileDirty = (! cppFile.exists() || (cppFile.getMTime() < config->_mTime));
-
-	if ( ! hFileDirty && ! cppFileDirty ) {
-		Log::f( "class files for class %s is up to date.", c._name.c_str() );
-		return;
-	}
+	bool classSerializable = c._serialized;
+	_inlineAccessors = c._inlineAccessors;
+	_inlineSerialization = c._staticDispatch && c._inlineAccessors;
 
-	// TODO: check mtime on file and skip all of this if possible
-
-	bool classSerializable = resolveClassSerializable( config->_package, c );
+	// the cold struct is only defined in the header if inline accessors need it there
+	_coldOutOfLine = c._hasColdFields && ! _inlineAccessors;
 
 	// make sure we can create files (and their parents)
 	File hOutputFileParent = hFile.getDir();
@@ -62,10 +420,17 @@ void CPPClassGenerator::generate(
 	}
 
 	File cppOutputFileParent = cppFile.getDir();
-	if ( ! cppOutputFileParent.exists() ) {
+	if ( ! _keepSource && ! cppOutputFileParent.exists() ) {
 		cppOutputFileParent.mkdir( true );
 	}
 
+	// the source includes the class's header, and the headers of the objects only its cold struct holds
+	_sourceIncludes.clear();
+	_sourceIncludes.push_back( hFilePath );
+	for ( const Symbol& typeName : getForwardDeclaredTypes( c )) {
+		_sourceIncludes.push_back( typeName.str() + ".gen.h" );
+	}
+
 	writeMainHeader();
 	_hStream << endl;
 
@@ -81,8 +446,23 @@ void CPPClassGenerator::generate(
 	writeHashDef( c );
 	_hStream << endl;
 
+	if ( _inlineAccessors ) {
+		writeConstexprDef();
+		_hStream << endl;
+	}
+
+	if ( hasFixedStrings( c )) {
+		writeFixedStringDef();
+		_hStream << endl;
+	}
+
+	if ( c._pmr && hasObjectFields( c )) {
+		writeMakeUsingAllocatorDef();
+		_hStream << endl;
+	}
+
 	// print out "class Foo {"
-	if ( classSerializable ) {
+	if ( classSerializable && ! c._staticDispatch ) {
 		_hStream << "class " << c._name << " : public Serializable {" << endl;
 		_hStream << endl;
 
@@ -91,39 +471,15 @@ void CPPClassGenerator::generate(
 		_hStream << endl;
 	}
 
-	// write header to _cppStream
-	writeCPPHeaderInclude( hFilePath.data() );
-	_cppStream << endl;
-
-	writeCPPUsingDeclarations( classSerializable );
-	_cppStream << endl;
-
-	list<Field> publicFields;
-	list<Field> protectedFields;
-	list<Field> privateFields;
-
-	for ( Field f : c._fields ) {
-
-		AccessPrivacy privacy = resolvePrivacy( config->_package, c, f );
-
-		switch ( privacy ) {
-
-			case AccessPrivacy::PRIVATE:
-				privateFields.push_back( f );
-				break;
-
-			case AccessPrivacy::PROTECTED:
-				protectedFields.push_back( f );
-				break;
-
-			case AccessPrivacy::PUBLIC:
-				publicFields.push_back( f );
-				break;
-
-			case AccessPrivacy::NONE:
-			default:
-				throw MissingAttributeException( "Must specify a root level defaultMemberPrivacy, a class defaultMemberPrivacy, or a field memberPrivacy setting" );
+	// write header to _cppStream (a unity source writes these once for all of its classes)
+	if ( ! _keepSource ) {
+		for ( const string& include : _sourceIncludes ) {
+			writeCPPHeaderInclude( include.c_str() );
 		}
+		_cppStream << endl;
+
+		writeCPPUsingDeclarations( classSerializable );
+		_cppStream << endl;
 	}
 
 	_hStream << "public:" << endl;
@@ -132,65 +488,69 @@ void CPPClassGenerator::generate(
 	// write s_classHash at top of cpp file
 	_cppStream << "int32_t " << c._name << "::s_classHash = " << "__CR_HASH_" << c._name << ";" << endl << endl;
 
+	// the cold struct has to be complete before any definition uses it
+	if ( _coldOutOfLine ) {
+		writeColdStructDefinition( c );
+	}
+
 	writeConstructors( c );
 
-	if ( publicFields.size() > 0 ) {
+	if ( c._pool ) {
+		_hStream	<< "\t// recycles objects through a thread local free list (pool=\"true\")" << endl
+					<< "\tclass Pool;" << endl
+					<< endl;
+	}
 
-		for ( Field f : publicFields ) {
-			writeField( f );
-		}
+	if ( ! c._compactLayout && hasFields( c, AccessPrivacy::PUBLIC )) {
 
-		_hStream << endl;
+		writeFields( c, AccessPrivacy::PUBLIC );
 
-		for ( Field f : publicFields ) {
-			writeFieldAccessors( c, f );
-			_hStream << endl;
-		}
+		_hStream << endl;
 	}
 
 	// while we're in public, write out all accessors
-	if ( protectedFields.size() > 0 ) {
-		for ( Field f : protectedFields ) {
-			writeFieldAccessors( c, f );
-			_hStream << endl;
-		}
-	}
-	if ( privateFields.size() > 0 ) {
-		for ( Field f : privateFields ) {
-			writeFieldAccessors( c, f );
-			_hStream << endl;
-		}
-	}
+	forEachField( c, [this, &c]( const Field& f ) {
+		writeFieldAccessors( c, f );
+		_hStream << endl;
+	} );
 
 	// write out serialization declarations
 	if ( classSerializable ) {
-		writeSerializationDeclarations();
+		writeSerializationDeclarations( c );
 		_hStream << endl;
 	}
 
 	// write out static method to return hash code
 	_hStream << "\tstatic int32_t s_classHash;" << endl << endl;
 
-	// add other fields by access type
-	if ( protectedFields.size() > 0 ) {
+	// add other fields by access type (or, for the compact layout, all fields in storage order)
+	if ( c._compactLayout ) {
+		writeCompactFields( c );
+	}
+
+	if ( ! c._compactLayout && hasFields( c, AccessPrivacy::PROTECTED )) {
 		
 		_hStream << "protected:" << endl;
 		_hStream << endl;
 
-		for ( Field f : protectedFields ) {
-			writeField( f );
-		}
+		writeFields( c, AccessPrivacy::PROTECTED );
 
 		_hStream << endl;
 	}
 
-	if ( privateFields.size() > 0 ) {
+	if ( ! c._compactLayout && (hasFields( c, AccessPrivacy::PRIVATE ) || c._packedBoolCount > 0 || c._hasColdFields )) {
 		
 		_hStream << "private:" << endl;
 		_hStream << endl;
 
-		for ( Field f : privateFields ) {
-			writeField( f );
+		writeFields( c, AccessPrivacy::PRIVATE );
+		writePackedBoolWords( c );
+
+		if ( c._hasColdFields ) {
+			if ( hasFields( c, AccessPrivacy::PRIVATE ) || c._packedBoolCount > 0 ) {
+				_hStream << endl;
+			}
+			writeColdFields( c, computeClassLayout( c, false )._coldFields );
 		}
 
 		_hStream << endl;
@@ -198,31 +558,54 @@ void CPPClassGenerator::generate(
 
 	// write serialization function definitions
 	if ( classSerializable ) {
-		writeSerializationDefinitions( c, publicFields, protectedFields, privateFields );
+		writeSerializationDefinitions( c );
 	}
 
 	// close class
 	_hStream << "};" << endl;
 	_hStream << endl;
 
+	if ( isTriviallyCopyable( c )) {
+		writeTriviallyCopyableAssert( c );
+	}
+
+	if ( c._pool ) {
+		writePool( c );
+	}
+
+	// the struct of arrays container follows the class it holds
+	if ( c._columns ) {
+		writeColumns( c );
+	}
+
+	// inline definitions follow the class, so that they can use all of its members
+	if ( _inlineAccessors ) {
+		_hStream.append( _inlineStream, 0, _inlineStream.size() );
+	}
+
 	writeEndIfdefs( c );
 
-	// take hash of the entire buffer, then go back and fill in hash
-	// TODO: this involves at least one big copy...
-	// NOTE: this needs to be updated if the "class Foo..." and the hash move with respect to each other (etc)
-	i32 hashCode = hash( _hStream.str().c_str() + _hashPosition2 + sizeof( "00000000\n */") );
-	// Log::i( "class text starts with: %s", _hStream.str().c_str() + _hashPosition + sizeof( "00000000\n */") );
+	// the hash of everything following the main header was computed as it was written; go back and 
+	// fill it in
+	i32 hashCode = _hStream.getHash();
 
 	substituteHash( hashCode, _hashPosition1 );
 	substituteHash( hashCode, _hashPosition2 );
 
-	ofstream hOutFileStream( hFile.getFullPath() );
-	hOutFileStream << _hStream.str();
-	hOutFileStream.close();
+	typedef std::chrono::high_resolution_clock Clock;
+	auto writeStart = Clock::now();
+
+	// leave unchanged files alone so that their dependents don't get rebuilt
+	stats._outputs[0]._bytes = _hStream.size();
+	stats._outputs[0]._written = _hStream.writeTo( hFile );
+	stats._filesWritten += stats._outputs[0]._written ? 1 : 0;
+	if ( ! _keepSource ) {
+		stats._outputs[1]._bytes = _cppStream.size();
+		stats._outputs[1]._written = _cppStream.writeTo( cppFile );
+		stats._filesWritten += stats._outputs[1]._written ? 1 : 0;
+	}
 
-	ofstream cppOutFileStream( cppFile.getFullPath() );
-	cppOutFileStream << _cppStream.str();
-	cppOutFileStream.close();
+	stats._writeTimeNanos = std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - writeStart ).count();
 }
 
 // writeStartIfdefs
@@ -245,17 +628,51 @@ void CPPClassGenerator::writeCPPUsingDeclarations( bool classSerializable ) {
 
 // writeHHeaderInclude
 void CPPClassGenerator::writeHHeaderInclude( bool classSerializable, const Class& c ) {
-	_hStream		<< "#include <string>" << endl
-				<< endl;
+
+	// objects only held by the out of line cold struct just need declaring
+	vector<Symbol> declaredTypes = getForwardDeclaredTypes( c );
+
+	if ( c._hasColdFields || (c._pmr && hasObjectFields( c ))) {
+		_hStream << "#include <memory>" << endl;
+	}
+	if ( c._pmr ) {
+		_hStream << "#include <memory_resource>" << endl;
+	}
+	_hStream		<< "#include <string>" << endl;
+	if ( c._pmr && hasPmrStrings( c )) {
+		_hStream	<< "#include <string_view>" << endl;
+	}
+	ui64 serializedSize;
+	if ( hasFixedStrings( c ) || hasFieldsSerializedAsBytes( c ) || getFixedSerializedSize( c, serializedSize )) {
+		_hStream	<< "#include <string.h>" << endl;
+	}
+	bool objectMoveTraits = hasObjectFields( c ) && (c._pmr || hasByteArrays( c ) || _coldOutOfLine);
+	if ( hasFixedStrings( c ) || objectMoveTraits || isTriviallyCopyable( c )) {
+		_hStream	<< "#include <type_traits>" << endl;
+	}
+	if ( c._pmr && hasObjectFields( c )) {
+		_hStream	<< "#include <utility>" << endl;
+	}
+	if ( c._columns || c._pool || hasPmrBlobs( c )) {
+		_hStream << "#include <vector>" << endl;
+	}
+	_hStream		<< endl;
 	if ( classSerializable ) {
 		_hStream		<< "#include \"core/serialization.h\"" << endl
-					<< endl
-					<< "#include \"base/serializable.h\"" << endl;
+						<< endl
+						<< "#include \"base/little_endian.h\"" << endl;
+		if ( ! c._staticDispatch ) {
+			_hStream	<< "#include \"base/serializable.h\"" << endl;
+		}
+		if ( hasVarints( c )) {
+			_hStream	<< "#include \"base/varint.h\"" << endl;
+		}
 
-		set<string> includedFiles;
+		// objects which are only declared aren't included
+		set<Symbol> includedFiles( declaredTypes.begin(), declaredTypes.end() );
 
 		bool addedBlankLine = false;
-		for ( Field f : c._fields ) {
+		for ( const Field& f : c._fields ) {
 
 			if ( f._dataType == DataType::OBJECT ) {
 
@@ -273,6 +690,40 @@ void CPPClassGenerator::writeHHeaderInclude( bool classSerializable, const Class
 			}
 		}
 	}
+
+	if ( ! declaredTypes.empty() ) {
+		_hStream << endl;
+		for ( const Symbol& typeName : declaredTypes ) {
+			_hStream << "class " << typeName << ";" << endl;
+		}
+	}
+}
+
+// getForwardDeclaredTypes
+vector<Symbol> CPPClassGenerator::getForwardDeclaredTypes( const Class& c ) const {
+
+	// FooColumns holds vectors of every field, which need complete types
+	vector<Symbol> types;
+	if ( ! _coldOutOfLine || c._columns ) {
+		return types;
+	}
+
+	set<Symbol> inlineTypes;
+	for ( const Field& f : c._fields ) {
+		if ( f._dataType == DataType::OBJECT && ! f._cold ) {
+			inlineTypes.insert( f._typeName );
+		}
+	}
+
+	set<Symbol> declared;
+	for ( const Field& f : c._fields ) {
+		if ( f._dataType == DataType::OBJECT && f._cold
+				&& inlineTypes.find( f._typeName ) == inlineTypes.end()
+				&& declared.insert( f._typeName ).second ) {
+			types.push_back( f._typeName );
+		}
+	}
+	return types;
 }
 
 // writeHUsingDeclarations
@@ -285,10 +736,108 @@ void CPPClassGenerator::writeHUsingDeclarations( bool classSerializable ) {
 // writeHashDef
 void CPPClassGenerator::writeHashDef( const Class& c ) {
 	_hStream	<< "#define __CR_HASH_" << c._name << " 0x00000000";
-	_hashPosition1 = (i64)_hStream.tellp() - 8;
+	_hashPosition1 = (i64)_hStream.size() - 8;
 	_hStream	<< endl;
 }
 
+// writeConstexprDef
+void CPPClassGenerator::writeConstexprDef() {
+
+	// constexpr setters need C++14 (C++11 makes constexpr member functions const and limits them to a
+	// return statement), but no accessor call can be a constant expression until C++20 lets an object
+	// whose constructor leaves fields uninitialized be created in one. Before then a constexpr accessor
+	// would be pointless, and strictly ill-formed (no diagnostic required)
+	_hStream	<< "#ifndef __CR_CONSTEXPR" << endl
+			<< "#if __cplusplus >= 202002L" << endl
+			<< "#define __CR_CONSTEXPR constexpr" << endl
+			<< "#else" << endl
+			<< "#define __CR_CONSTEXPR" << endl
+			<< "#endif" << endl
+			<< "#endif" << endl;
+}
+
+// writeFixedStringDef
+void CPPClassGenerator::writeFixedStringDef() {
+
+	// every header with fixed strings carries the template, so it is guarded like a header
+	_hStream	<< "#ifndef __CR_FIXED_STRING_" << endl
+			<< "#define __CR_FIXED_STRING_" << endl
+			<< endl
+			<< "namespace cr {" << endl
+			<< endl
+			<< "/**" << endl
+			<< " * A string of at most N bytes, stored inline as a length and a NUL terminated array. Longer" << endl
+			<< " * values are truncated to N bytes." << endl
+			<< " */" << endl
+			<< "template<size_t N>" << endl
+			<< "class FixedString {" << endl
+			<< endl
+			<< "public:" << endl
+			<< endl
+			<< "\tFixedString() : _length(0) {" << endl
+			<< "\t\t_data[0] = '\\0';" << endl
+			<< "\t}" << endl
+			<< endl
+			<< "\tFixedString( const char* value ) {" << endl
+			<< "\t\tassign( value, strlen( value ));" << endl
+			<< "\t}" << endl
+			<< endl
+			<< "\tFixedString( const char* value, size_t length ) {" << endl
+			<< "\t\tassign( value, length );" << endl
+			<< "\t}" << endl
+			<< endl
+			<< "\tFixedString( const std::string& value ) {" << endl
+			<< "\t\tassign( value.data(), value.size() );" << endl
+			<< "\t}" << endl
+			<< endl
+			<< "\tvoid assign( const char* value, size_t length ) {" << endl
+			<< "\t\t_length = (LengthType)(length < N ? length : N);" << endl
+			<< "\t\tmemcpy( _data, value, _length );" << endl
+			<< "\t\t_data[_length] = '\\0';" << endl
+			<< "\t}" << endl
+			<< endl
+			<< "\tvoid clear() {" << endl
+			<< "\t\t_length = 0;" << endl
+			<< "\t\t_data[0] = '\\0';" << endl
+			<< "\t}" << endl
+			<< endl
+			<< "\tconst char* c_str() const { return _data; }" << endl
+			<< "\tconst char* data() const { return _data; }" << endl
+			<< "\tsize_t size() const { return _length; }" << endl
+			<< "\tbool empty() const { return _length == 0; }" << endl
+			<< "\tstatic size_t capacity() { return N; }" << endl
+			<< "\tstd::string str() const { return std::string( _data, _length ); }" << endl
+			<< endl
+			<< "\tbool operator==( const FixedString& other ) const {" << endl
+			<< "\t\treturn _length == other._length && memcmp( _data, other._data, _length ) == 0;" << endl
+			<< "\t}" << endl
+			<< endl
+			<< "\tbool operator!=( const FixedString& other ) const {" << endl
+			<< "\t\treturn ! (*this == other);" << endl
+			<< "\t}" << endl
+			<< endl
+			<< "private:" << endl
+			<< endl
+			<< "\t// the smallest unsigned type holding N" << endl
+			<< "\ttypedef typename std::conditional<(N < 0x100), uint8_t," << endl
+			<< "\t\t\ttypename std::conditional<(N < 0x10000), uint16_t, uint32_t>::type>::type LengthType;" << endl
+			<< endl
+			<< "\tLengthType _length;" << endl
+			<< "\tchar _data[N + 1];" << endl
+			<< "};" << endl
+			<< endl
+			<< "}" << endl
+			<< endl
+			<< "#endif" << endl;
+}
+
+// getConstexprSpecifier
+const char* CPPClassGenerator::getConstexprSpecifier( const Field& f ) const {
+
+	// only inline accessors of primitives stored in the class itself qualify
+	return (_inlineAccessors && isPrimitive( f ) && ! f._cold) ? "__CR_CONSTEXPR " : "";
+}
+
 // writeMainHeader
 void CPPClassGenerator::writeMainHeader() {
 	_hStream	<< "/**" << endl
@@ -297,119 +846,336 @@ void CPPClassGenerator::writeMainHeader() {
 			<< " *" << endl
 			<< " * CodeRoller git hash: " << GIT_HASH << endl
 			<< " * CodeRoller git branch: " << GIT_BRANCH << endl
-			<< " *" << endl
-			<< " * Generated on " << getTimeMillis() << endl
-			<< " * Class hash: 00000000";
+			<< " *" << endl;
+
+	// a timestamp would make every run's output differ
+	if ( ! g_deterministic ) {
+		_hStream << " * Generated on " << getTimeMillis() << endl;
+	}
+
+	_hStream	<< " * Class hash: 00000000";
 	
 	// grab position here; we will return to it to overwrite class hash once we can compute it.
-	_hashPosition2 = (i64)_hStream.tellp() - 8;
+	_hashPosition2 = (i64)_hStream.size() - 8;
 
 	// finish writing header
 
 	_hStream	<< endl
 			<< " */" << endl;
+
+	// the class hash covers everything from here on
+	_hStream.startHash();
 }
 
 // writeConstructors
 void CPPClassGenerator::writeConstructors( const Class& c ) {
-	_hStream	<< "\t// declare default empty ctor and dtor" << endl
-				<< "\t" << c._name << "() = default;" << endl // empty ctor
-				<< "\t~" << c._name << "() = default;" << endl // dtor
-				<< endl
-				<< "\t// declare default copy ctor/assignment and let the compiler generate it if possible" << endl
-				<< "\t" << c._name << "( const " << c._name << "& other ) = default;" << endl // copy ctor
-				<< "\t" << c._name << "& operator=( const " << c._name << "& other ) = default;" << endl // copy assignment
-				<< endl
-				<< "\t// declare custom move ctor/assignment" << endl
-				<< "\t" << c._name << "( " << c._name << "&& other );" << endl // move ctor
-				<< "\t" << c._name << "& operator=( " << c._name << "&& other );" << endl // move assignment
-				<< endl
+	if ( _coldOutOfLine ) {
+		_hStream	<< "\t// declare empty ctor and dtor, defaulted where the cold struct is complete" << endl
+					<< "\t" << c._name << "();" << endl // empty ctor
+					<< "\t~" << c._name << "();" << endl // dtor
+					<< endl;
+
+		_cppStream	<< c._name << "::" << c._name << "() = default;" << endl
+					<< c._name << "::~" << c._name << "() = default;" << endl
+					<< endl;
+	} else {
+		_hStream	<< "\t// declare default empty ctor and dtor" << endl
+					<< "\t" << c._name << "() = default;" << endl // empty ctor
+					<< "\t~" << c._name << "() = default;" << endl // dtor
+					<< endl;
+	}
+
+	if ( c._hasColdFields ) {
+		_hStream	<< "\t// declare custom copy ctor/assignment, which also copy the cold fields" << endl
+					<< "\t" << c._name << "( const " << c._name << "& other );" << endl // copy ctor
+					<< "\t" << c._name << "& operator=( const " << c._name << "& other );" << endl; // copy assignment
+	} else {
+		_hStream	<< "\t// declare default copy ctor/assignment and let the compiler generate it if possible" << endl
+					<< "\t" << c._name << "( const " << c._name << "& other ) = default;" << endl // copy ctor
+					<< "\t" << c._name << "& operator=( const " << c._name << "& other ) = default;" << endl; // copy assignment
+	}
+
+	// defaulted moves are noexcept whenever the fields' moves are, so containers of the class move
+	// rather than copy it. ByteArray has no move, so blobs are swapped by custom moves instead (and a
+	// std::pmr class has none, since swapping containers using different resources is undefined).
+	bool customMoves = hasByteArrays( c );
+	if ( customMoves ) {
+		_hStream	<< endl
+					<< "\t// declare custom move ctor/assignment" << endl
+					<< "\t" << c._name << "( " << c._name << "&& other ) " << getMoveNoexceptSpecifier( c, false ) << ";" << endl // move ctor
+					<< "\t" << c._name << "& operator=( " << c._name << "&& other ) " << getMoveNoexceptSpecifier( c, true ) << ";" << endl; // move assignment
+	} else if ( _coldOutOfLine ) {
+		_hStream	<< endl
+					<< "\t// declare move ctor/assignment, defaulted where the cold struct is complete" << endl
+					<< "\t" << c._name << "( " << c._name << "&& other ) " << getMoveNoexceptSpecifier( c, false ) << ";" << endl // move ctor
+					<< "\t" << c._name << "& operator=( " << c._name << "&& other ) " << getMoveNoexceptSpecifier( c, true ) << ";" << endl; // move assignment
+
+		_cppStream	<< c._name << "::" << c._name << "( " << c._name << "&& other ) " << getMoveNoexceptSpecifier( c, false ) << " = default;" << endl
+					<< c._name << "& " << c._name << "::operator=( " << c._name << "&& other ) " << getMoveNoexceptSpecifier( c, true ) << " = default;" << endl
+					<< endl;
+	} else {
+		_hStream	<< endl
+					<< "\t// declare default move ctor/assignment" << endl
+					<< "\t" << c._name << "( " << c._name << "&& other ) = default;" << endl // move ctor
+					<< "\t" << c._name << "& operator=( " << c._name << "&& other ) = default;" << endl; // move assignment
+	}
+
+	if ( c._pmr ) {
+		writeAllocatorConstructors( c );
+	}
+
+	_hStream	<< endl
 				<< "\t// copy convenience functions" << endl
 				<< "\tvoid copyFrom( const " << c._name << "& other );" << endl // copy()
 				<< "\t" << c._name << " clone() const;" << endl // copy()
 				<< endl;
 
+	TextBuffer& out = getDefinitionStream();
+
+	// copy ctor/assignment
+	if ( c._hasColdFields ) {
+		out	<< getDefinitionSpecifier() << c._name << "::" << c._name << "( const " << c._name << "& other ) {" << endl
+					<< "\tcopyFrom( other );" << endl
+					<< "}" << endl
+					<< endl;
+
+		out	<< getDefinitionSpecifier() << c._name << "& " << c._name << "::operator=( const " << c._name << "& other ) {" << endl
+					<< "\tcopyFrom( other );" << endl
+					<< "\treturn *this;" << endl
+					<< "}" << endl
+					<< endl;
+	}
+
+	if ( ! customMoves ) {
+		writeCopyFunctions( c );
+		return;
+	}
+
 	// move ctor
-	_cppStream	<< c._name << "::" << c._name << "( " << c._name << "&& other ) {" << endl;
-	for ( Field f : c._fields ) {
-		writeMoveAssignment( f );
+	out	<< getDefinitionSpecifier() << c._name << "::" << c._name << "( " << c._name << "&& other ) " << getMoveNoexceptSpecifier( c, false ) << " {" << endl;
+	for ( const Field& f : c._fields ) {
+		if ( ! f._cold && f._bitIndex < 0 ) {
+			writeMoveAssignment( f );
+		}
+	}
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+		out << "\t" << getPackedBoolWordName( c, i ) << " = other." << getPackedBoolWordName( c, i ) << ";" << endl;
+	}
+	if ( c._hasColdFields ) {
+		out << "\t_cold = std::move( other._cold );" << endl;
 	}
-	_cppStream	<< "}" << endl
+	out	<< "}" << endl
 				<< endl;
 
 	// move assignment
-	_cppStream	<< c._name << "& " << c._name << "::operator=( " << c._name << "&& other ) {" << endl;
-	for ( Field f : c._fields ) {
-		writeMoveAssignment( f );
+	out	<< getDefinitionSpecifier() << c._name << "& " << c._name << "::operator=( " << c._name << "&& other ) " << getMoveNoexceptSpecifier( c, true ) << " {" << endl;
+	for ( const Field& f : c._fields ) {
+		if ( ! f._cold && f._bitIndex < 0 ) {
+			writeMoveAssignment( f );
+		}
+	}
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+		out << "\t" << getPackedBoolWordName( c, i ) << " = other." << getPackedBoolWordName( c, i ) << ";" << endl;
 	}
-	_cppStream	<< "\treturn *this;" << endl
+	if ( c._hasColdFields ) {
+		out << "\t_cold = std::move( other._cold );" << endl;
+	}
+	out	<< "\treturn *this;" << endl
 				<< "}" << endl
 				<< endl;
 
+	writeCopyFunctions( c );
+}
+
+// writeCopyFunctions
+void CPPClassGenerator::writeCopyFunctions( const Class& c ) {
+
+	TextBuffer& out = getDefinitionStream();
+
 	// copyFrom
-	_cppStream	<< "void " << c._name << "::copyFrom( const " << c._name << "& other ) {" << endl;
-	for ( Field f : c._fields ) {
-		writeCopyAssignment( f );
+	out	<< getDefinitionSpecifier() << "void " << c._name << "::copyFrom( const " << c._name << "& other ) {" << endl;
+	for ( const Field& f : c._fields ) {
+		if ( ! f._cold && f._bitIndex < 0 ) {
+			writeCopyAssignment( f );
+		}
 	}
-	_cppStream	<< "}" << endl
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+		out << "\t" << getPackedBoolWordName( c, i ) << " = other." << getPackedBoolWordName( c, i ) << ";" << endl;
+	}
+	if ( c._hasColdFields ) {
+		out << "\t_cold.reset( other._cold ? new Cold( *other._cold ) : nullptr );" << endl;
+	}
+	out	<< "}" << endl
 				<< endl;
 
 	// clone
-	_cppStream	<< c._name << " " << c._name << "::clone() const {" << endl 
+	out	<< getDefinitionSpecifier() << c._name << " " << c._name << "::clone() const {" << endl 
 				<< "\t" << c._name << " copy;" << endl;
-	for ( Field f : c._fields ) {
-		writeCloneAssignment( f );
+	for ( const Field& f : c._fields ) {
+		if ( ! f._cold && f._bitIndex < 0 ) {
+			writeCloneAssignment( f );
+		}
+	}
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+		out << "\tcopy." << getPackedBoolWordName( c, i ) << " = " << getPackedBoolWordName( c, i ) << ";" << endl;
 	}
-	_cppStream	<< "\treturn copy;" << endl
+	if ( c._hasColdFields ) {
+		out << "\tcopy._cold.reset( _cold ? new Cold( *_cold ) : nullptr );" << endl;
+	}
+	out	<< "\treturn copy;" << endl
 				<< "}" << endl
 				<< endl;
 
 }
 
-// writeMoveAssignment
-void CPPClassGenerator::writeMoveAssignment( const Field& f ) {
-	if ( f._dataType == DataType::STRING || f._dataType == DataType::BLOB ) {
-		_cppStream	<< "\t_" << f._name << ".swap( other._" << f._name << " );" << endl;
-	} else if (  f._dataType == DataType::OBJECT ) {
-		_cppStream	<< "\t_" << f._name << " = std::move( other._" << f._name << " );" << endl;
-	} else {
-		_cppStream	<< "\t_" << f._name << " = other._" << f._name << ";" << endl;
+// getMoveNoexceptSpecifier
+string CPPClassGenerator::getMoveNoexceptSpecifier( const Class& c, bool assignment ) const {
+
+	// strings, primitives and the cold pointer move without throwing, but objects are up to their class
+	string condition;
+	set<Symbol> types;
+	for ( const Field& f : c._fields ) {
+		if ( f._dataType == DataType::OBJECT && ! f._cold && types.insert( f._typeName ).second ) {
+			condition += condition.empty() ? "" : " && ";
+			condition += (assignment ? "std::is_nothrow_move_assignable<" : "std::is_nothrow_move_constructible<") + f._typeName.str() + ">::value";
+		}
 	}
+	return condition.empty() ? "noexcept" : "noexcept( " + condition + " )";
+}
 
+// writeTriviallyCopyableAssert
+void CPPClassGenerator::writeTriviallyCopyableAssert( const Class& c ) {
+	_hStream	<< "// holding only primitives, " << c._name << " can be copied with memcpy" << endl
+				<< "static_assert( std::is_trivially_copyable<" << c._name << ">::value, \"" << c._name << " should be trivially copyable\" );" << endl
+				<< endl;
 }
 
-// writeCopyAssignment
-void CPPClassGenerator::writeCopyAssignment( const Field& f ) {
-	if ( f._dataType == DataType::BLOB || f._dataType == DataType::OBJECT ) {
-		_cppStream	<< "\t_" << f._name << ".copyFrom( other._" << f._name << " );" << endl;
-	} else {
-		_cppStream	<< "\t_" << f._name << " = other._" << f._name << ";" << endl;
+// writeAllocatorConstructors
+void CPPClassGenerator::writeAllocatorConstructors( const Class& c ) {
+
+	// the ctors std::uses_allocator construction (e.g. by a std::pmr::vector<Foo>) calls
+	_hStream	<< endl
+				<< "\t// declare allocator-aware ctors: strings and blobs allocate from the allocator's memory" << endl
+				<< "\t// resource, and objects which are allocator-aware themselves are passed it too" << endl
+				<< "\ttypedef std::pmr::polymorphic_allocator<char> allocator_type;" << endl
+				<< "\texplicit " << c._name << "( const allocator_type& allocator );" << endl
+				<< "\t" << c._name << "( const " << c._name << "& other, const allocator_type& allocator );" << endl
+				<< "\t" << c._name << "( " << c._name << "&& other, const allocator_type& allocator );" << endl;
+
+	TextBuffer& out = getDefinitionStream();
+	const char* specifier = getDefinitionSpecifier();
+
+	// members are initialized in the order they are declared
+	vector<const Field*> fields = getStoredFields( c );
+
+	// the empty ctor leaves primitives uninitialized, like the default one
+	out << specifier << c._name << "::" << c._name << "( const allocator_type& allocator )";
+	const char* separator = " :";
+	for ( const Field* f : fields ) {
+		if ( f->_pmr ) {
+			out << separator << endl << "\t\t\t\t_" << f->_name << "(allocator)";
+			separator = ",";
+		} else if ( f->_dataType == DataType::OBJECT ) {
+			out << separator << endl << "\t\t\t\t_" << f->_name << "(cr::makeUsingAllocator<" << f->_typeName << ">( allocator ))";
+			separator = ",";
+		}
+	}
+	out	<< " {" << endl
+		<< "}" << endl
+		<< endl;
+
+	for ( bool move : { false, true } ) {
+
+		out << specifier << c._name << "::" << c._name << "( " << (move ? "" : "const ") << c._name << (move ? "&&" : "&") << " other, const allocator_type& allocator )";
+
+		separator = " :";
+		for ( const Field* f : fields ) {
+			out << separator << endl << "\t\t\t\t_" << f->_name;
+			if ( f->_pmr ) {
+				out << "(" << (move ? "std::move( other._" + f->_name.str() + " )" : "other._" + f->_name.str()) << ", allocator)";
+			} else if ( f->_dataType == DataType::OBJECT ) {
+				out << "(cr::makeUsingAllocator<" << f->_typeName << ">( allocator, " << (move ? "std::move( other._" + f->_name.str() + " ))" : "other._" + f->_name.str() + " )") << ")";
+			} else {
+				out << "(other._" << f->_name << ")";
+			}
+			separator = ",";
+		}
+		for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+			out << separator << endl << "\t\t\t\t" << getPackedBoolWordName( c, i ) << "(other." << getPackedBoolWordName( c, i ) << ")";
+			separator = ",";
+		}
+		out	<< " {" << endl
+			<< "}" << endl
+			<< endl;
+	}
+}
+
+// writeMakeUsingAllocatorDef
+void CPPClassGenerator::writeMakeUsingAllocatorDef() {
+
+	// every header with pmr objects carries the template, so it is guarded like a header
+	_hStream	<< "#ifndef __CR_MAKE_USING_ALLOCATOR_" << endl
+			<< "#define __CR_MAKE_USING_ALLOCATOR_" << endl
+			<< endl
+			<< "namespace cr {" << endl
+			<< endl
+			<< "/**" << endl
+			<< " * Construct a T from the given arguments, passing it the allocator too if it is allocator-aware" << endl
+			<< " */" << endl
+			<< "template<typename T, typename... Args>" << endl
+			<< "T makeUsingAllocator( const std::pmr::polymorphic_allocator<char>& allocator, Args&&... args ) {" << endl
+			<< "\tif constexpr ( std::uses_allocator<T, std::pmr::polymorphic_allocator<char>>::value ) {" << endl
+			<< "\t\treturn T( std::forward<Args>( args )..., allocator );" << endl
+			<< "\t} else {" << endl
+			<< "\t\treturn T( std::forward<Args>( args )... );" << endl
+			<< "\t}" << endl
+			<< "}" << endl
+			<< endl
+			<< "}" << endl
+			<< endl
+			<< "#endif" << endl;
+}
+
+// writeMoveAssignment
+void CPPClassGenerator::writeMoveAssignment( const Field& f ) {
+	TextBuffer& out = getDefinitionStream();
+	if ( isByteArray( f )) {
+		out	<< "\t_" << f._name << ".swap( other._" << f._name << " );" << endl;
+	} else if ( (f._dataType == DataType::STRING && ! isFixedString( f )) || f._dataType == DataType::OBJECT ) {
+		out	<< "\t_" << f._name << " = std::move( other._" << f._name << " );" << endl;
+	} else {
+		out	<< "\t_" << f._name << " = other._" << f._name << ";" << endl;
+	}
+
+}
+
+// writeCopyAssignment
+void CPPClassGenerator::writeCopyAssignment( const Field& f ) {
+	TextBuffer& out = getDefinitionStream();
+	if ( isByteArray( f ) || f._dataType == DataType::OBJECT ) {
+		out	<< "\t_" << f._name << ".copyFrom( other._" << f._name << " );" << endl;
+	} else {
+		out	<< "\t_" << f._name << " = other._" << f._name << ";" << endl;
 	}
 
 }
 
 // writeCloneAssignment
 void CPPClassGenerator::writeCloneAssignment( const Field& f ) {
-	if ( f._dataType == DataType::BLOB || f._dataType == DataType::OBJECT ) {
-		_cppStream	<< "\tcopy._" << f._name << ".copyFrom( _" << f._name << " );" << endl;
+	TextBuffer& out = getDefinitionStream();
+	if ( isByteArray( f ) || f._dataType == DataType::OBJECT ) {
+		out	<< "\tcopy._" << f._name << ".copyFrom( _" << f._name << " );" << endl;
 	} else {
-		_cppStream	<< "\tcopy._" << f._name << " = _" << f._name << ";" << endl;
+		out	<< "\tcopy._" << f._name << " = _" << f._name << ";" << endl;
 	}
 }
 
 // writeFieldAccessors
 void CPPClassGenerator::writeFieldAccessors( const Class& c, const Field& f ) {
 
-	string capitalized;
-	capitalized += capitalize( f._name[0] );
-	capitalized += (f._name.c_str() + 1);
-
-	string typeName;
-	if ( f._dataType == DataType::OBJECT ) {
-		typeName = f._typeName;
-	} else {
-		typeName = getDataTypeName( f._dataType );
-	}
+	const Symbol& capitalized = f._capitalizedName;
+	string typeName = getFieldTypeName( f );
+	const char* constexprSpecifier = getConstexprSpecifier( f );
 
 	// write declarations
 	if ( f._dataType == DataType::STRING || f._dataType == DataType::OBJECT ) {
@@ -417,8 +1183,12 @@ void CPPClassGenerator::writeFieldAccessors( const Class& c, const Field& f ) {
 		// string type
 		_hStream << "\t" << typeName << "& get" << capitalized << "();" << endl;
 		_hStream << "\tconst " << typeName << "& get" << capitalized << "() const;" << endl;
-		_hStream << "\tvoid" << " set" << capitalized << "( const " << typeName << "& value );" << endl;
-		_hStream << "\tvoid" << " set" << capitalized << "( " << typeName << "&& value );" << endl;
+		if ( f._pmr ) {
+			_hStream << "\tvoid" << " set" << capitalized << "( std::string_view value );" << endl;
+		} else {
+			_hStream << "\tvoid" << " set" << capitalized << "( const " << typeName << "& value );" << endl;
+			_hStream << "\tvoid" << " set" << capitalized << "( " << typeName << "&& value );" << endl;
+		}
 
 	} else if ( f._dataType == DataType::BLOB ) {
 
@@ -429,58 +1199,71 @@ void CPPClassGenerator::writeFieldAccessors( const Class& c, const Field& f ) {
 	} else {
 
 		// handle primitive types
-		_hStream << "\t" << typeName << " get" << capitalized << "() const;" << endl;
-		_hStream << "\tvoid" << " set" << capitalized << "( " << typeName << " value );" << endl;
+		_hStream << "\t" << constexprSpecifier << typeName << " get" << capitalized << "() const;" << endl;
+		_hStream << "\t" << constexprSpecifier << "void" << " set" << capitalized << "( " << typeName << " value );" << endl;
 	}
 
 	// write definitions
+	TextBuffer& out = getDefinitionStream();
+	const char* specifier = getDefinitionSpecifier();
+
 	if ( f._dataType == DataType::STRING || f._dataType == DataType::OBJECT ) {
 
 		// getter non-const
-		_cppStream << typeName << "& " << c._name << "::" << "get" << capitalized << "() {" << endl;
-		_cppStream << "\treturn _" << f._name << ";" << endl;
-		_cppStream << "}" << endl;
-		_cppStream << endl;
+		out << specifier << typeName << "& " << c._name << "::" << "get" << capitalized << "() {" << endl;
+		out << "\treturn " << getWriteExpression( f ) << ";" << endl;
+		out << "}" << endl;
+		out << endl;
 
 		// getter const
-		_cppStream << "const " << typeName << "& " << c._name << "::" << "get" << capitalized << "() const {" << endl;
-		_cppStream << "\treturn _" << f._name << ";" << endl;
-		_cppStream << "}" << endl;
-		_cppStream << endl;
-
-		// setter
-		_cppStream << "void " << c._name << "::" << "set" << capitalized << "( const " << typeName << "& value ) {" << endl;
+		out << specifier << "const " << typeName << "& " << c._name << "::" << "get" << capitalized << "() const {" << endl;
+		out << "\treturn " << getReadExpression( f ) << ";" << endl;
+		out << "}" << endl;
+		out << endl;
+
+		// a std::pmr::string is set from a view, since a temporary would allocate from the default resource
+		if ( f._pmr ) {
+			out << specifier << "void " << c._name << "::" << "set" << capitalized << "( std::string_view value ) {" << endl;
+			out << "\t" << getWriteExpression( f ) << ".assign( value.data(), value.size() );" << endl;
+			out << "}" << endl;
+			out << endl;
 
-		if ( f._dataType == DataType::STRING ) {
-			_cppStream << "\t_" << f._name << " = value;" << endl;
 		} else {
-			_cppStream << "\t_" << f._name << ".copyFrom( value );" << endl;
-		}
 
-		_cppStream << "}" << endl;
-		_cppStream << endl;
+			// setter
+			out << specifier << "void " << c._name << "::" << "set" << capitalized << "( const " << typeName << "& value ) {" << endl;
 
-		// move setter
-		_cppStream << "void " << c._name << "::" << "set" << capitalized << "( " << typeName << "&& value ) {" << endl;
-		_cppStream << "\t_" << f._name << " = std::move( value );" << endl;
-		_cppStream << "}" << endl;
-		_cppStream << endl;
+			if ( f._dataType == DataType::STRING ) {
+				out << "\t" << getWriteExpression( f ) << " = value;" << endl;
+			} else {
+				out << "\t" << getWriteExpression( f ) << ".copyFrom( value );" << endl;
+			}
+
+			out << "}" << endl;
+			out << endl;
+
+			// move setter
+			out << specifier << "void " << c._name << "::" << "set" << capitalized << "( " << typeName << "&& value ) {" << endl;
+			out << "\t" << getWriteExpression( f ) << " = std::move( value );" << endl;
+			out << "}" << endl;
+			out << endl;
+		}
 
 	} else if ( f._dataType == DataType::BLOB ) {
 
 		// blob type
 
 		// getter non-const
-		_cppStream << typeName << "& " << c._name << "::" << "get" << capitalized << "() {" << endl;
-		_cppStream << "\treturn _" << f._name << ";" << endl;
-		_cppStream << "}" << endl;
-		_cppStream << endl;
+		out << specifier << typeName << "& " << c._name << "::" << "get" << capitalized << "() {" << endl;
+		out << "\treturn " << getWriteExpression( f ) << ";" << endl;
+		out << "}" << endl;
+		out << endl;
 
 		// getter const
-		_cppStream << "const " << typeName << "& " << c._name << "::" << "get" << capitalized << "() const {" << endl;
-		_cppStream << "\treturn _" << f._name << ";" << endl;
-		_cppStream << "}" << endl;
-		_cppStream << endl;
+		out << specifier << "const " << typeName << "& " << c._name << "::" << "get" << capitalized << "() const {" << endl;
+		out << "\treturn " << getReadExpression( f ) << ";" << endl;
+		out << "}" << endl;
+		out << endl;
 
 
 	} else {
@@ -488,27 +1271,158 @@ void CPPClassGenerator::writeFieldAccessors( const Class& c, const Field& f ) {
 		// handle primitive types
 
 		// getter
-		_cppStream << typeName << " " << c._name << "::" << "get" << capitalized << "() const {" << endl;
-		_cppStream << "\treturn _" << f._name << ";" << endl;
-		_cppStream << "}" << endl;
-		_cppStream << endl;
+		out << specifier << constexprSpecifier << typeName << " " << c._name << "::" << "get" << capitalized << "() const {" << endl;
+		if ( f._bitIndex >= 0 ) {
+			out << "\treturn (" << getPackedBoolWord( c, f ) << " & " << getPackedBoolMask( c, f ) << ") != 0;" << endl;
+		} else {
+			out << "\treturn " << getReadExpression( f ) << ";" << endl;
+		}
+		out << "}" << endl;
+		out << endl;
 
 		// setter
-		_cppStream << "void " << c._name << "::" << "set" << capitalized << "( " << typeName << " value ) {" << endl;
-		_cppStream << "\t_" << f._name << " = value;" << endl;
-		_cppStream << "}" << endl;
-		_cppStream << endl;
+		out << specifier << constexprSpecifier << "void " << c._name << "::" << "set" << capitalized << "( " << typeName << " value ) {" << endl;
+		if ( f._bitIndex >= 0 ) {
+			string word = getPackedBoolWord( c, f );
+			string mask = getPackedBoolMask( c, f );
+			out << "\t" << word << " = (" << getPackedBoolWordType( c ) << ")(value ? (" << word << " | " << mask << ") : (" << word << " & ~" << mask << "));" << endl;
+		} else {
+			out << "\t" << getWriteExpression( f ) << " = value;" << endl;
+		}
+		out << "}" << endl;
+		out << endl;
 	}
 
 }
 
 // writeField
 void CPPClassGenerator::writeField( const Field& f ) {
-	if ( f._dataType == DataType::OBJECT ) {
-		_hStream << "\t" << f._typeName << " _" << f._name << ";" << endl;
+	writeField( f, _hStream );
+}
+
+// writeField
+void CPPClassGenerator::writeField( const Field& f, TextBuffer& out ) {
+	out << "\t" << getFieldTypeName( f ) << " _" << f._name << ";" << endl;
+}
+
+// writeFields
+void CPPClassGenerator::writeFields( const Class& c, AccessPrivacy privacy ) {
+	for ( const Field& f : c._fields ) {
+		if ( f._privacy == privacy && ! f._cold && f._bitIndex < 0 ) {
+			writeField( f );
+		}
+	}
+}
+
+// writeCompactFields
+void CPPClassGenerator::writeCompactFields( const Class& c ) {
+
+	ClassLayout layout = computeClassLayout( c, true );
+
+	_hStream << "\t// fields are ordered by alignment to minimize padding (layout=\"compact\"); estimated size "
+			<< layout._size << " bytes" << (layout._exact ? "" : " plus objects")
+			<< ", " << layout._padding << " of them padding" << endl;
+
+	// compilers lay members out in declaration order, even across access specifiers
+	AccessPrivacy privacy = AccessPrivacy::PUBLIC;
+
+	// the cold struct's pointer goes first
+	if ( c._hasColdFields ) {
+		privacy = AccessPrivacy::PRIVATE;
+		_hStream << endl;
+		_hStream << "private:" << endl;
+		_hStream << endl;
+		writeColdFields( c, layout._coldFields );
+		_hStream << endl;
+	}
+
+	for ( const Field* f : layout._fields ) {
+		if ( f->_privacy != privacy ) {
+			privacy = f->_privacy;
+			_hStream << endl;
+			_hStream << getPrivacyName( privacy ) << ":" << endl;
+			_hStream << endl;
+		}
+		writeField( *f );
+	}
+
+	if ( c._packedBoolCount > 0 ) {
+		if ( privacy != AccessPrivacy::PRIVATE ) {
+			_hStream << endl;
+			_hStream << "private:" << endl;
+			_hStream << endl;
+		}
+		writePackedBoolWords( c );
+	}
+
+	_hStream << endl;
+}
+
+// writePackedBoolWords
+void CPPClassGenerator::writePackedBoolWords( const Class& c ) {
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+		_hStream << "\t" << getPackedBoolWordType( c ) << " " << getPackedBoolWordName( c, i ) << "; // bool fields (packBools=\"true\")" << endl;
+	}
+}
+
+// writeColdFields
+void CPPClassGenerator::writeColdFields( const Class& c, const vector<const Field*>& coldFields ) {
+
+	_hStream << "\t// fields which aren't hot=\"true\" are stored out of line, allocated on first write" << endl;
+	if ( _coldOutOfLine ) {
+		_hStream << "\tstruct Cold; // defined in the .gen.cpp" << endl;
 	} else {
-		_hStream << "\t" << getDataTypeName( f._dataType ) << " _" << f._name << ";" << endl;
+		_hStream << "\tstruct Cold {" << endl;
+		for ( const Field* f : coldFields ) {
+			_hStream << "\t";
+			writeField( *f );
+		}
+		_hStream << "\t};" << endl;
 	}
+	_hStream << "\tstd::unique_ptr<Cold> _cold;" << endl;
+	_hStream << "\tstatic const Cold s_defaultCold; // read while _cold is unallocated" << endl;
+	_hStream << endl;
+	_hStream << "\tCold& mutableCold();" << endl;
+	_hStream << "\tconst Cold& getCold() const;" << endl;
+
+	_cppStream << "const " << c._name << "::Cold " << c._name << "::s_defaultCold = " << c._name << "::Cold();" << endl;
+	_cppStream << endl;
+
+	TextBuffer& out = getDefinitionStream();
+
+	out << getDefinitionSpecifier() << c._name << "::Cold& " << c._name << "::mutableCold() {" << endl;
+	out << "\tif ( ! _cold ) {" << endl;
+	out << "\t\t_cold.reset( new Cold() );" << endl;
+	out << "\t}" << endl;
+	out << "\treturn *_cold;" << endl;
+	out << "}" << endl;
+	out << endl;
+
+	out << getDefinitionSpecifier() << "const " << c._name << "::Cold& " << c._name << "::getCold() const {" << endl;
+	out << "\treturn _cold ? *_cold : s_defaultCold;" << endl;
+	out << "}" << endl;
+	out << endl;
+}
+
+// writeColdStructDefinition
+void CPPClassGenerator::writeColdStructDefinition( const Class& c ) {
+
+	_cppStream << "struct " << c._name << "::Cold {" << endl;
+	for ( const Field* f : computeClassLayout( c, c._compactLayout )._coldFields ) {
+		writeField( *f, _cppStream );
+	}
+	_cppStream	<< "};" << endl
+				<< endl;
+}
+
+// hasFields
+bool CPPClassGenerator::hasFields( const Class& c, AccessPrivacy privacy ) {
+	for ( const Field& f : c._fields ) {
+		if ( f._privacy == privacy && ! f._cold && f._bitIndex < 0 ) {
+			return true;
+		}
+	}
+	return false;
 }
 
 // writeEndIfdefs
@@ -518,142 +1432,1140 @@ void CPPClassGenerator::writeEndIfdefs( const Class& c ) {
 }
 
 // substituteHash
-void CPPClassGenerator::substituteHash( i32 hash, i64 streamPos ) {
+void CPPClassGenerator::substituteHash( i32 hash, i64 position ) {
 
-	_hStream.seekp( streamPos, std::ios_base::beg );
+	// print in hex. This is deliberately not zero padded: hashes have always been written this way
+	// (over the start of the placeholder), and changing it would change existing class hashes.
+	char hex[9];
+	i32 length = snprintf( hex, sizeof( hex ), "%x", (ui32)hash );
 
-	// print in hex
-	_hStream << std::hex << hash;
-	_hStream << std::dec;
+	_hStream.patch( position, hex, length );
+}
+
+// writeSerializationDeclarations
+void CPPClassGenerator::writeSerializationDeclarations( const Class& c ) {
 
-	// seek back to end
-	_hStream.seekp( 0, std::ios_base::end );
+	// with static dispatch, the class doesn't implement Serializable
+	if ( c._staticDispatch ) {
+		_hStream << "\t// serialization functions (dispatch=\"static\": they aren't virtual)" << endl;
+	}
+	const char* specifier = c._staticDispatch ? "" : "virtual ";
+	_hStream << "\t" << specifier << "i64 serialize( void* buffer ) const;" << endl
+			<< "\t" << specifier << "i64 getSerializedSize() const;" << endl
+			<< "\t" << specifier << "i64 internalize( void* buffer );" << endl
+			<< "\t" << specifier << "i64 internalize( const void* buffer, i64 bufferSize );" << endl
+			<< "\t" << specifier << "int32_t getClassHash() const;" << endl;
+
+	// listing them also changes the class hash when a field's encoding does
+	if ( hasVarints( c )) {
+		_hStream << "\t// written as varints (encoding=\"varint\"):";
+		const char* separator = " ";
+		forEachSerializedField( c, [this, &separator]( const Field& f ) {
+			if ( f._varint ) {
+				_hStream << separator << "_" << f._name;
+				separator = ", ";
+			}
+		} );
+		_hStream << endl;
+	}
 
+	ui64 serializedSize;
+	if ( getFixedSerializedSize( c, serializedSize )) {
+		writeWireDeclarations( c, serializedSize );
+	}
 }
 
-// writeSerializationDeclarations
-void CPPClassGenerator::writeSerializationDeclarations() {
-	_hStream << "\tvirtual i64 serialize( void* buffer ) const;" << endl
-			<< "\tvirtual i64 getSerializedSize() const;" << endl
-			<< "\tvirtual i64 internalize( void* buffer );" << endl
-			<< "\tvirtual int32_t getClassHash() const;" << endl;
+// writeWireDeclarations
+void CPPClassGenerator::writeWireDeclarations( const Class& c, ui64 serializedSize ) {
+
+	vector<WireMember> members;
+	getWireMembers( c, members );
+
+	_hStream	<< endl
+				<< "\t// every serialized field has a fixed width, so the serialized size is known at compile time" << endl
+				<< "\tstatic constexpr i64 s_serializedSize = " << serializedSize << ";" << endl
+				<< endl
+				<< "\t// the wire format, which serialize() and internalize() copy at once (its members are little endian)" << endl
+				<< "#pragma pack(push, 1)" << endl
+				<< "\tstruct Wire {" << endl;
+	for ( const WireMember& member : members ) {
+		_hStream << "\t\t" << member._typeName << " " << member._name << ";" << endl;
+	}
+	_hStream	<< "\t};" << endl
+				<< "#pragma pack(pop)" << endl
+				<< "\tstatic_assert( sizeof( Wire ) == s_serializedSize, \"" << c._name << "::Wire should be packed\" );" << endl;
 }
 
 // writeSerializationDeclarations
-void CPPClassGenerator::writeSerializationDefinitions( const Class& c, list<Field>& publicFields, list<Field>& protectedFields, list<Field>& privateFields ) {
+void CPPClassGenerator::writeSerializationDefinitions( const Class& c ) {
 
-	writeSerialize( c, publicFields, protectedFields, privateFields );
-	_cppStream << endl;
+	TextBuffer& out = getSerializationStream();
 
-	writeGetSerializedSize( c, publicFields, protectedFields, privateFields );
-	_cppStream << endl;
+	ui64 serializedSize;
+	if ( getFixedSerializedSize( c, serializedSize )) {
+		writeWireSerializationDefinitions( c );
+		out << endl;
 
-	writeInternalize( c, publicFields, protectedFields, privateFields );
-	_cppStream << endl;
+		writeGetClassHash( c );
+		out << endl;
+		return;
+	}
+
+	writeSerialize( c );
+	out << endl;
+
+	writeGetSerializedSize( c );
+	out << endl;
+
+	writeInternalize( c );
+	out << endl;
+
+	writeCheckedInternalize( c );
+	out << endl;
 
 	writeGetClassHash( c );
-	_cppStream << endl;
+	out << endl;
 }
 
 // writeSerialize
-void CPPClassGenerator::writeSerialize( const Class& c, list<Field>& publicFields, list<Field>& protectedFields, list<Field>& privateFields ) {
+void CPPClassGenerator::writeSerialize( const Class& c ) {
 
-	_cppStream << "i64 " << c._name << "::serialize( void* buffer ) const {" << endl;
-	_cppStream << "\ti64 written = 0;" << endl;
+	TextBuffer& out = getSerializationStream();
 
-	for ( Field f : publicFields ) {
-		writeSerializeField( f );
-	}
-	for ( Field f : protectedFields ) {
-		writeSerializeField( f );
-	}
-	for ( Field f : privateFields ) {
-		writeSerializeField( f );
-	}
+	out << getSerializationSpecifier() << "i64 " << c._name << "::serialize( void* buffer ) const {" << endl;
+	out << "\ti64 written = 0;" << endl;
 
-	_cppStream	<< "\treturn written;" << endl
-				<< "}" << endl;
+	// packed bools are all written at once, where the first of them would be
+	bool packedBoolsWritten = false;
+	forEachSerializedField( c, [this, &c, &packedBoolsWritten]( const Field& f ) {
+		if ( f._bitIndex < 0 ) {
+			writeSerializeField( f );
+		} else if ( ! packedBoolsWritten ) {
+			writeSerializePackedBools( c );
+			packedBoolsWritten = true;
+		}
+	} );
+
+	out	<< "\treturn written;" << endl
+		<< "}" << endl;
 }
 
 // writeSerializeField
 void CPPClassGenerator::writeSerializeField( const Field& f ) {
+	TextBuffer& out = getSerializationStream();
 	if ( f._dataType == DataType::OBJECT ) {
-		_cppStream << "\twritten += _" << f._name << ".serialize( ((char*)buffer + written) );" << endl;
+		out << "\twritten += " << getReadExpression( f ) << ".serialize( ((char*)buffer + written) );" << endl;
+	} else if ( isSerializedAsBytes( f )) {
+		writeSerializeBytes( out, getReadExpression( f ), "\t" );
+	} else if ( isByteArray( f )) {
+		out << "\twritten += Serialization::write( ((char*)buffer + written), " << getReadExpression( f ) << " );" << endl;
+	} else if ( f._varint ) {
+		out << "\twritten += Varint::write( ((char*)buffer + written), " << getVarintValue( f, getReadExpression( f )) << " );" << endl;
 	} else {
-		_cppStream << "\twritten += Serialization::write( ((char*)buffer + written), _" << f._name << " );" << endl;
+		out << "\twritten += LittleEndian::write( ((char*)buffer + written), " << getReadExpression( f ) << " );" << endl;
 	}
 }
 
-// writeGetSerializedSize
-void CPPClassGenerator::writeGetSerializedSize( const Class& c, list<Field>& publicFields, list<Field>& protectedFields, list<Field>& privateFields ) {
+// writeSerializeBytes
+void CPPClassGenerator::writeSerializeBytes( TextBuffer& out, const string& value, const char* indent ) {
 
-	_cppStream	<< "i64 " << c._name << "::getSerializedSize() const {" << endl
-				<< "\ti64 size = 0;" << endl;
+	// same wire format as a ByteArray: the length as an i64, then the bytes. An empty vector's data()
+	// may be null, which memcpy mustn't be given even for no bytes
+	out	<< indent << "written += LittleEndian::write( ((char*)buffer + written), (i64)" << value << ".size() );" << endl
+		<< indent << "if ( " << value << ".size() ) {" << endl
+		<< indent << "\tmemcpy( ((char*)buffer + written), " << value << ".data(), " << value << ".size() );" << endl
+		<< indent << "\twritten += " << value << ".size();" << endl
+		<< indent << "}" << endl;
+}
 
-	for ( Field f : publicFields ) {
-		writeGetSerializedSizeField( f );
-	}
-	for ( Field f : protectedFields ) {
-		writeGetSerializedSizeField( f );
-	}
-	for ( Field f : privateFields ) {
-		writeGetSerializedSizeField( f );
+// writeSerializePackedBools
+void CPPClassGenerator::writeSerializePackedBools( const Class& c ) {
+
+	TextBuffer& out = getSerializationStream();
+
+	// each word holding serialized bools is written whole, with the bits of the unserialized ones cleared
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+
+		ui64 bits = getSerializedPackedBoolBits( c, i );
+		if ( bits == 0 ) {
+			continue;
+		}
+
+		string word = getPackedBoolWordName( c, i );
+		if ( isFullPackedBoolMask( c, bits )) {
+			out << "\twritten += LittleEndian::write( ((char*)buffer + written), " << word << " );" << endl;
+		} else {
+			out << "\twritten += LittleEndian::write( ((char*)buffer + written), (" << getPackedBoolWordType( c ) << ")(" << word << " & " << getPackedBoolLiteral( c, bits ) << ") );" << endl;
+		}
 	}
+}
 
-	_cppStream	<< "\treturn size;" << endl
-				<< "}" << endl;
+// writeGetSerializedSize
+void CPPClassGenerator::writeGetSerializedSize( const Class& c ) {
+
+	TextBuffer& out = getSerializationStream();
+
+	out	<< getSerializationSpecifier() << "i64 " << c._name << "::getSerializedSize() const {" << endl
+		<< "\ti64 size = 0;" << endl;
+
+	bool packedBoolsWritten = false;
+	forEachSerializedField( c, [this, &c, &packedBoolsWritten]( const Field& f ) {
+		if ( f._bitIndex < 0 ) {
+			writeGetSerializedSizeField( f );
+		} else if ( ! packedBoolsWritten ) {
+			writeGetSerializedSizePackedBools( c );
+			packedBoolsWritten = true;
+		}
+	} );
+
+	out	<< "\treturn size;" << endl
+		<< "}" << endl;
 }
 
 // writeGetSerializedSizeField
 void CPPClassGenerator::writeGetSerializedSizeField( const Field& f ) {
+	TextBuffer& out = getSerializationStream();
 	if ( f._dataType == DataType::STRING ) {
-		_cppStream << "\tsize += sizeof( i64 ) + _" << f._name << ".size(); // _" << f._name << endl;
+		out << "\tsize += sizeof( i64 ) + " << getReadExpression( f ) << ".size(); // _" << f._name << endl;
 	} else if ( f._dataType == DataType::BLOB ) {
-		_cppStream << "\tsize += sizeof( i64 ) + _" << f._name << ".getSize(); // _" << f._name << endl;
+		out << "\tsize += sizeof( i64 ) + " << getReadExpression( f ) << (f._pmr ? ".size()" : ".getSize()") << "; // _" << f._name << endl;
 	} else if ( f._dataType == DataType::OBJECT ) {
-		_cppStream << "\tsize += _" << f._name << ".getSerializedSize(); // _" << f._name << endl;
+		out << "\tsize += " << getReadExpression( f ) << ".getSerializedSize(); // _" << f._name << endl;
+	} else if ( f._varint ) {
+		out << "\tsize += Varint::getSize( " << getVarintValue( f, getReadExpression( f )) << " ); // _" << f._name << endl;
 	} else {
-		_cppStream << "\tsize += sizeof( " << getDataTypeName( f._dataType ) << " ); // _" << f._name << endl;
+		out << "\tsize += sizeof( " << getDataTypeName( f._dataType ) << " ); // _" << f._name << endl;
+	}
+}
+
+// writeGetSerializedSizePackedBools
+void CPPClassGenerator::writeGetSerializedSizePackedBools( const Class& c ) {
+	TextBuffer& out = getSerializationStream();
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+		if ( getSerializedPackedBoolBits( c, i ) != 0 ) {
+			out << "\tsize += sizeof( " << getPackedBoolWordType( c ) << " ); // " << getPackedBoolWordName( c, i ) << endl;
+		}
 	}
 }
 
 // writeInternalize
-void CPPClassGenerator::writeInternalize( const Class& c, list<Field>& publicFields, list<Field>& protectedFields, list<Field>& privateFields ) {
+void CPPClassGenerator::writeInternalize( const Class& c ) {
 
-	_cppStream << "i64 " << c._name << "::internalize( void* buffer ) {" << endl;
-	_cppStream << "\ti64 read = 0;" << endl;
+	TextBuffer& out = getSerializationStream();
 
-	for ( Field f : publicFields ) {
-		writeInternalizeField( f );
-	}
-	for ( Field f : protectedFields ) {
-		writeInternalizeField( f );
+	out << getSerializationSpecifier() << "i64 " << c._name << "::internalize( void* buffer ) {" << endl;
+	out << "\ti64 read = 0;" << endl;
+
+	bool packedBoolsRead = false;
+	forEachSerializedField( c, [this, &c, &packedBoolsRead]( const Field& f ) {
+		if ( f._bitIndex < 0 ) {
+			writeInternalizeField( f );
+		} else if ( ! packedBoolsRead ) {
+			writeInternalizePackedBools( c );
+			packedBoolsRead = true;
+		}
+	} );
+
+	out	<< "\treturn read;" << endl
+		<< "}" << endl;
+}
+
+// writeCheckedInternalize
+void CPPClassGenerator::writeCheckedInternalize( const Class& c ) {
+
+	TextBuffer& out = getSerializationStream();
+
+	// the serialized fields in wire order, with the first packed bool standing for all of the words
+	vector<const Field*> fields;
+	bool packedBoolsAdded = false;
+	forEachSerializedField( c, [&fields, &packedBoolsAdded]( const Field& f ) {
+		if ( f._bitIndex < 0 || ! packedBoolsAdded ) {
+			fields.push_back( &f );
+			packedBoolsAdded |= f._bitIndex >= 0;
+		}
+	} );
+
+	// the fixed size fields up to the first variable size one are checked at once, up front; every
+	// variable size field is checked once, along with the fixed size fields up to the next one
+	out << getSerializationSpecifier() << "i64 " << c._name << "::internalize( const void* buffer, i64 bufferSize ) {" << endl;
+	i64 runSize = getCheckedRunSize( c, fields, 0 );
+	if ( runSize > 0 ) {
+		writeBoundsCheck( out, "bufferSize < " + std::to_string( runSize ), "" );
 	}
-	for ( Field f : privateFields ) {
-		writeInternalizeField( f );
+	out << "\ti64 read = 0;" << endl;
+
+	for ( size_t i = 0; i < fields.size(); i++ ) {
+
+		const Field& f = *fields[i];
+		i64 followingSize = getCheckedRunSize( c, fields, i + 1 );
+
+		if ( f._bitIndex >= 0 ) {
+			writeInternalizePackedBools( c );
+		} else if ( isSerializedAsBytes( f )) {
+			writeInternalizeBytes( out, f, getWriteExpression( f ), "\t", followingSize );
+		} else if ( isByteArray( f )) {
+			out	<< "\t{" << endl
+				<< "\t\ti64 length;" << endl
+				<< "\t\tLittleEndian::read( ((const char*)buffer + read), &length );" << endl;
+			writeBoundsCheck( out, "length < 0 || " + getBoundsCondition( "length", sizeof( i64 ) + followingSize ), "\t" );
+			out	<< "\t}" << endl
+				<< "\tread += Serialization::read( ((char*)buffer + read), " << getWriteExpression( f ) << " );" << endl;
+		} else if ( f._dataType == DataType::OBJECT ) {
+			out	<< "\t{" << endl
+				<< "\t\ti64 size = " << getWriteExpression( f ) << ".internalize( ((const char*)buffer + read), bufferSize - read );" << endl;
+			writeBoundsCheck( out, getReadSizeCondition( followingSize ), "\t" );
+			out	<< "\t\tread += size;" << endl
+				<< "\t}" << endl;
+		} else if ( f._varint ) {
+			writeInternalizeVarint( out, f, getWriteExpression( f ), "\t", followingSize );
+		} else {
+			writeInternalizeField( f );
+		}
 	}
 
-	_cppStream	<< "\treturn read;" << endl
-				<< "}" << endl;
+	out	<< "\treturn read;" << endl
+		<< "}" << endl;
+}
+
+// writeBoundsCheck
+void CPPClassGenerator::writeBoundsCheck( TextBuffer& out, const string& condition, const char* indent ) {
+	out	<< indent << "\tif ( " << condition << " ) {" << endl
+		<< indent << "\t\treturn -1;" << endl
+		<< indent << "\t}" << endl;
 }
 
 // writeInternalizeField
 void CPPClassGenerator::writeInternalizeField( const Field& f ) {
-	if ( f._dataType == DataType::STRING || f._dataType == DataType::BLOB ) {
-		_cppStream << "\tread += Serialization::read( ((char*)buffer + read), _" << f._name << " );" << endl;
+	TextBuffer& out = getSerializationStream();
+	if ( isSerializedAsBytes( f )) {
+		writeInternalizeBytes( out, f, getWriteExpression( f ), "\t", -1 );
+	} else if ( isByteArray( f )) {
+		out << "\tread += Serialization::read( ((char*)buffer + read), " << getWriteExpression( f ) << " );" << endl;
 	} else if ( f._dataType == DataType::OBJECT ) {
-		_cppStream << "\tread += _" << f._name << ".internalize( ((char*)buffer + read) );" << endl;
+		out << "\tread += " << getWriteExpression( f ) << ".internalize( ((char*)buffer + read) );" << endl;
+	} else if ( f._varint ) {
+		writeInternalizeVarint( out, f, getWriteExpression( f ), "\t", -1 );
 	} else {
-		_cppStream << "\tread += Serialization::read( ((char*)buffer + read), &_" << f._name << " );" << endl;
+		out << "\tread += LittleEndian::read( ((const char*)buffer + read), &" << getWriteExpression( f ) << " );" << endl;
+	}
+}
+
+// writeInternalizeBytes
+void CPPClassGenerator::writeInternalizeBytes( TextBuffer& out, const Field& f, const string& value, const char* indent, i64 followingSize ) {
+
+	// a longer string than a cr::FixedString holds is truncated, but read whole
+	out	<< indent << "{" << endl
+		<< indent << "\ti64 length;" << endl
+		<< indent << "\tread += LittleEndian::read( ((const char*)buffer + read), &length );" << endl;
+	if ( followingSize >= 0 ) {
+		writeBoundsCheck( out, "length < 0 || " + getBoundsCondition( "length", followingSize ), indent );
+	}
+	if ( f._dataType == DataType::BLOB ) {
+		out << indent << "\t" << value << ".assign( ((const char*)buffer + read), ((const char*)buffer + read + length) );" << endl;
+	} else {
+		out << indent << "\t" << value << ".assign( ((const char*)buffer + read), (size_t)length );" << endl;
+	}
+	out	<< indent << "\tread += length;" << endl
+		<< indent << "}" << endl;
+}
+
+// writeInternalizeVarint
+void CPPClassGenerator::writeInternalizeVarint( TextBuffer& out, const Field& f, const string& value, const char* indent, i64 followingSize ) {
+
+	string decoded = isSignedInteger( f._dataType ) ? "Varint::zigzagDecode( value )" : "value";
+	out	<< indent << "{" << endl
+		<< indent << "\tui64 value;" << endl;
+	if ( followingSize >= 0 ) {
+		out << indent << "\ti64 size = Varint::read( ((const char*)buffer + read), bufferSize - read, &value );" << endl;
+		writeBoundsCheck( out, getReadSizeCondition( followingSize ), indent );
+		out << indent << "\tread += size;" << endl;
+	} else {
+		out << indent << "\tread += Varint::read( ((const char*)buffer + read), &value );" << endl;
+	}
+	out	<< indent << "\t" << value << " = (" << getDataTypeName( f._dataType ) << ")" << decoded << ";" << endl
+		<< indent << "}" << endl;
+}
+
+// writeInternalizePackedBools
+void CPPClassGenerator::writeInternalizePackedBools( const Class& c ) {
+
+	TextBuffer& out = getSerializationStream();
+
+	// the bits of unserialized bools keep their values
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+
+		ui64 bits = getSerializedPackedBoolBits( c, i );
+		if ( bits == 0 ) {
+			continue;
+		}
+
+		string word = getPackedBoolWordName( c, i );
+		if ( isFullPackedBoolMask( c, bits )) {
+			out << "\tread += LittleEndian::read( ((const char*)buffer + read), &" << word << " );" << endl;
+		} else {
+			string mask = getPackedBoolLiteral( c, bits );
+			out	<< "\t{" << endl
+				<< "\t\t" << getPackedBoolWordType( c ) << " value;" << endl
+				<< "\t\tread += LittleEndian::read( ((const char*)buffer + read), &value );" << endl
+				<< "\t\t" << word << " = (" << getPackedBoolWordType( c ) << ")((" << word << " & ~" << mask << ") | (value & " << mask << "));" << endl
+				<< "\t}" << endl;
+		}
 	}
 }
 
 // writeGetClassHash
 void CPPClassGenerator::writeGetClassHash( const Class& c ) {
 
-	_cppStream	<< "int32_t " << c._name << "::getClassHash() const {" << endl
-				<< "\treturn __CR_HASH_" << c._name << ";" << endl
-				<< "}" << endl;
+	TextBuffer& out = getSerializationStream();
+
+	out	<< getSerializationSpecifier() << "int32_t " << c._name << "::getClassHash() const {" << endl
+		<< "\treturn __CR_HASH_" << c._name << ";" << endl
+		<< "}" << endl;
+}
+
+// writeWireSerializationDefinitions
+void CPPClassGenerator::writeWireSerializationDefinitions( const Class& c ) {
+
+	TextBuffer& out = getSerializationStream();
+
+	vector<WireMember> members;
+	getWireMembers( c, members );
+
+	// until C++17 made it implicitly inline, a static constexpr member used by reference needs a definition
+	_cppStream	<< "#if __cplusplus < 201703L" << endl
+				<< "constexpr i64 " << c._name << "::s_serializedSize;" << endl
+				<< "#endif" << endl
+				<< endl;
+
+	// serialize: packed bool words are written with the bits of unserialized bools cleared
+	out	<< getSerializationSpecifier() << "i64 " << c._name << "::serialize( void* buffer ) const {" << endl
+		<< "\tWire wire;" << endl;
+	for ( const WireMember& member : members ) {
+		if ( member._field ) {
+			out << "\twire." << member._name << " = LittleEndian::fromHost( " << getReadExpression( *member._field ) << " );" << endl;
+		} else if ( isFullPackedBoolMask( c, member._bits )) {
+			out << "\twire." << member._name << " = LittleEndian::fromHost( " << member._name << " );" << endl;
+		} else {
+			out << "\twire." << member._name << " = LittleEndian::fromHost( (" << member._typeName << ")(" << member._name << " & " << getPackedBoolLiteral( c, member._bits ) << ") );" << endl;
+		}
+	}
+	out	<< "\tmemcpy( buffer, &wire, sizeof( wire ));" << endl
+		<< "\treturn s_serializedSize;" << endl
+		<< "}" << endl
+		<< endl;
+
+	// getSerializedSize
+	out	<< getSerializationSpecifier() << "i64 " << c._name << "::getSerializedSize() const {" << endl
+		<< "\treturn s_serializedSize;" << endl
+		<< "}" << endl;
+
+	// internalize (unchecked, then bounds checked): the bits of unserialized bools keep their values
+	for ( bool checked : { false, true } ) {
+
+		out << endl;
+		if ( checked ) {
+			out << getSerializationSpecifier() << "i64 " << c._name << "::internalize( const void* buffer, i64 bufferSize ) {" << endl;
+			writeBoundsCheck( out, "bufferSize < s_serializedSize", "" );
+		} else {
+			out << getSerializationSpecifier() << "i64 " << c._name << "::internalize( void* buffer ) {" << endl;
+		}
+
+		out	<< "\tWire wire;" << endl
+			<< "\tmemcpy( &wire, buffer, sizeof( wire ));" << endl;
+		for ( const WireMember& member : members ) {
+			if ( member._field ) {
+				out << "\t" << getWriteExpression( *member._field ) << " = LittleEndian::toHost( wire." << member._name << " );" << endl;
+			} else if ( isFullPackedBoolMask( c, member._bits )) {
+				out << "\t" << member._name << " = LittleEndian::toHost( wire." << member._name << " );" << endl;
+			} else {
+				string mask = getPackedBoolLiteral( c, member._bits );
+				out << "\t" << member._name << " = (" << member._typeName << ")((" << member._name << " & ~" << mask << ") | (LittleEndian::toHost( wire." << member._name << " ) & " << mask << "));" << endl;
+			}
+		}
+		out	<< "\treturn s_serializedSize;" << endl
+			<< "}" << endl;
+	}
+}
+
+// writePool
+void CPPClassGenerator::writePool( const Class& c ) {
+
+	const string pool = c._name.str() + "::Pool";
+
+	_hStream	<< "/**" << endl
+				<< " * Thread local free list recycling " << c._name << " objects. release() resets an object and keeps it" << endl
+				<< " * for the next acquire() on the same thread, so its strings and blobs keep their capacity" << endl
+				<< " */" << endl
+				<< "class " << pool << " {" << endl
+				<< endl
+				<< "public:" << endl
+				<< endl
+				<< "\t/**" << endl
+				<< "\t * Owns an object acquired from the pool, and releases it back when destroyed" << endl
+				<< "\t */" << endl
+				<< "\tclass Handle {" << endl
+				<< endl
+				<< "\tpublic:" << endl
+				<< endl
+				<< "\t\tHandle() : _object(nullptr) {}" << endl
+				<< "\t\texplicit Handle( " << c._name << "* object ) : _object(object) {}" << endl
+				<< "\t\tHandle( Handle&& other ) noexcept : _object(other.detach()) {}" << endl
+				<< "\t\tHandle& operator=( Handle&& other ) { reset( other.detach() ); return *this; }" << endl
+				<< "\t\tHandle( const Handle& other ) = delete;" << endl
+				<< "\t\tHandle& operator=( const Handle& other ) = delete;" << endl
+				<< "\t\t~Handle() { reset(); }" << endl
+				<< endl
+				<< "\t\t" << c._name << "* get() const { return _object; }" << endl
+				<< "\t\t" << c._name << "& operator*() const { return *_object; }" << endl
+				<< "\t\t" << c._name << "* operator->() const { return _object; }" << endl
+				<< "\t\texplicit operator bool() const { return _object != nullptr; }" << endl
+				<< endl
+				<< "\t\t// give up the object without releasing it" << endl
+				<< "\t\t" << c._name << "* detach() { " << c._name << "* object = _object; _object = nullptr; return object; }" << endl
+				<< endl
+				<< "\t\t// release the object (if any) and own the given one instead" << endl
+				<< "\t\tvoid reset( " << c._name << "* object = nullptr ) { if ( _object ) { Pool::release( _object ); } _object = object; }" << endl
+				<< endl
+				<< "\tprivate:" << endl
+				<< endl
+				<< "\t\t" << c._name << "* _object;" << endl
+				<< "\t};" << endl
+				<< endl
+				<< "\t// an object from this thread's free list, or a new one; either way it holds default values" << endl
+				<< "\tstatic " << c._name << "* acquire();" << endl
+				<< "\tstatic Handle acquireHandle();" << endl
+				<< endl
+				<< "\t// reset the object and keep it in this thread's free list (deleting it if the list is full)" << endl
+				<< "\tstatic void release( " << c._name << "* object );" << endl
+				<< endl
+				<< "\t// number of objects in this thread's free list" << endl
+				<< "\tstatic size_t size();" << endl
+				<< endl
+				<< "\t// limit this thread's free list to the given number of objects (" << CR_DEFAULT_POOL_CAPACITY << " by default)" << endl
+				<< "\tstatic void setCapacity( size_t capacity );" << endl
+				<< endl
+				<< "\t// delete the objects in this thread's free list" << endl
+				<< "\tstatic void clear();" << endl
+				<< endl
+				<< "private:" << endl
+				<< endl
+				<< "\tstruct FreeList {" << endl
+				<< "\t\tstd::vector<" << c._name << "*> _objects;" << endl
+				<< "\t\tsize_t _capacity = " << CR_DEFAULT_POOL_CAPACITY << ";" << endl
+				<< "\t\t~FreeList();" << endl
+				<< "\t};" << endl
+				<< endl
+				<< "\tstatic FreeList& getFreeList();" << endl
+				<< "\tstatic void resetObject( " << c._name << "& object );" << endl
+				<< "};" << endl
+				<< endl;
+
+	TextBuffer& out = getDefinitionStream();
+	string specifier = getDefinitionSpecifier();
+
+	// ~FreeList (run as each thread exits)
+	out	<< specifier << pool << "::FreeList::~FreeList() {" << endl
+		<< "\tfor ( " << c._name << "* object : _objects ) {" << endl
+		<< "\t\tdelete object;" << endl
+		<< "\t}" << endl
+		<< "}" << endl
+		<< endl;
+
+	// getFreeList
+	out	<< specifier << pool << "::FreeList& " << pool << "::getFreeList() {" << endl
+		<< "\tstatic thread_local FreeList freeList;" << endl
+		<< "\treturn freeList;" << endl
+		<< "}" << endl
+		<< endl;
+
+	// acquire
+	out	<< specifier << c._name << "* " << pool << "::acquire() {" << endl
+		<< "\tFreeList& freeList = getFreeList();" << endl
+		<< "\tif ( freeList._objects.empty() ) {" << endl;
+	if ( _coldOutOfLine ) {
+		// the constructor is user provided (defaulted in the .gen.cpp), so new doesn't zero the fields
+		out	<< "\t\t" << c._name << "* object = new " << c._name << "();" << endl
+			<< "\t\tresetObject( *object );" << endl
+			<< "\t\treturn object;" << endl;
+	} else {
+		out << "\t\treturn new " << c._name << "();" << endl;
+	}
+	out	<< "\t}" << endl
+		<< "\t" << c._name << "* object = freeList._objects.back();" << endl
+		<< "\tfreeList._objects.pop_back();" << endl
+		<< "\treturn object;" << endl
+		<< "}" << endl
+		<< endl;
+
+	// acquireHandle
+	out	<< specifier << pool << "::Handle " << pool << "::acquireHandle() {" << endl
+		<< "\treturn Handle( acquire() );" << endl
+		<< "}" << endl
+		<< endl;
+
+	// release
+	out	<< specifier << "void " << pool << "::release( " << c._name << "* object ) {" << endl
+		<< "\tif ( ! object ) {" << endl
+		<< "\t\treturn;" << endl
+		<< "\t}" << endl
+		<< "\tFreeList& freeList = getFreeList();" << endl
+		<< "\tif ( freeList._objects.size() >= freeList._capacity ) {" << endl
+		<< "\t\tdelete object;" << endl
+		<< "\t\treturn;" << endl
+		<< "\t}" << endl
+		<< "\tresetObject( *object );" << endl
+		<< "\tfreeList._objects.push_back( object );" << endl
+		<< "}" << endl
+		<< endl;
+
+	// size
+	out	<< specifier << "size_t " << pool << "::size() {" << endl
+		<< "\treturn getFreeList()._objects.size();" << endl
+		<< "}" << endl
+		<< endl;
+
+	// setCapacity
+	out	<< specifier << "void " << pool << "::setCapacity( size_t capacity ) {" << endl
+		<< "\tFreeList& freeList = getFreeList();" << endl
+		<< "\tfreeList._capacity = capacity;" << endl
+		<< "\twhile ( freeList._objects.size() > capacity ) {" << endl
+		<< "\t\tdelete freeList._objects.back();" << endl
+		<< "\t\tfreeList._objects.pop_back();" << endl
+		<< "\t}" << endl
+		<< "}" << endl
+		<< endl;
+
+	// clear
+	out	<< specifier << "void " << pool << "::clear() {" << endl
+		<< "\tFreeList& freeList = getFreeList();" << endl
+		<< "\tfor ( " << c._name << "* object : freeList._objects ) {" << endl
+		<< "\t\tdelete object;" << endl
+		<< "\t}" << endl
+		<< "\tfreeList._objects.clear();" << endl
+		<< "}" << endl
+		<< endl;
+
+	// resetObject: clear rather than reassign strings and blobs, so that they keep their buffers
+	out	<< specifier << "void " << pool << "::resetObject( " << c._name << "& object ) {" << endl;
+	for ( const Field& f : c._fields ) {
+		if ( ! f._cold && f._bitIndex < 0 ) {
+			writePoolFieldReset( f, "object._" );
+		}
+	}
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+		out << "\tobject." << getPackedBoolWordName( c, i ) << " = 0;" << endl;
+	}
+	if ( c._hasColdFields ) {
+		out << "\tif ( object._cold ) {" << endl;
+		for ( const Field& f : c._fields ) {
+			if ( f._cold ) {
+				out << "\t";
+				writePoolFieldReset( f, "object._cold->_" );
+			}
+		}
+		out << "\t}" << endl;
+	}
+	out	<< "}" << endl
+		<< endl;
+}
+
+// writePoolFieldReset
+void CPPClassGenerator::writePoolFieldReset( const Field& f, const string& object ) {
+	TextBuffer& out = getDefinitionStream();
+	if ( isByteArray( f )) {
+		out << "\t" << object << f._name << ".copyFrom( ByteArray() );" << endl;
+	} else if ( f._dataType == DataType::STRING || f._dataType == DataType::BLOB ) {
+		out << "\t" << object << f._name << ".clear();" << endl;
+	} else {
+		out << "\t" << object << f._name << " = " << getFieldTypeName( f ) << "();" << endl;
+	}
+}
+
+// writeColumns
+void CPPClassGenerator::writeColumns( const Class& c ) {
+
+	string columns = c._name.str() + "Columns";
+
+	_hStream	<< "/**" << endl
+			<< " * Struct of arrays container for " << c._name << ", holding one contiguous vector per field." << endl
+			<< " */" << endl
+			<< "class " << columns << " {" << endl
+			<< endl
+			<< "public:" << endl
+			<< endl;
+
+	writeColumnsRowDeclaration( c, false );
+	_hStream << endl;
+
+	writeColumnsRowDeclaration( c, true );
+	_hStream << endl;
+
+	_hStream	<< "\t" << columns << "() : _size(0) {}" << endl
+			<< endl;
+
+	if ( c._pmr ) {
+		_hStream	<< "\t// the columns (and their strings and blobs) allocate from the given memory resource" << endl
+				<< "\ttypedef std::pmr::polymorphic_allocator<char> allocator_type;" << endl
+				<< "\texplicit " << columns << "( const allocator_type& allocator ) :" << endl
+				<< "\t\t\t\t_size(0)";
+		for ( const Field& f : c._fields ) {
+			_hStream << "," << endl << "\t\t\t\t_" << f._name << "(allocator)";
+		}
+		_hStream	<< " {" << endl
+				<< "\t}" << endl
+				<< endl;
+	}
+
+	_hStream	<< "\tsize_t size() const;" << endl
+			<< "\tbool empty() const;" << endl
+			<< "\tvoid reserve( size_t capacity );" << endl
+			<< "\tvoid clear();" << endl
+			<< endl
+			<< "\t// append a copy of (or move) an object's fields" << endl
+			<< "\tvoid push_back( const " << c._name << "& value );" << endl
+			<< "\tvoid push_back( " << c._name << "&& value );" << endl
+			<< endl
+			<< "\t// copy a row out into an object" << endl
+			<< "\t" << c._name << " get( size_t index ) const;" << endl
+			<< endl
+			<< "\tRow operator[]( size_t index );" << endl
+			<< "\tConstRow operator[]( size_t index ) const;" << endl
+			<< endl
+			<< "\t// direct access to the columns; they must not be resized" << endl;
+
+	for ( const Field& f : c._fields ) {
+		_hStream	<< "\t" << getColumnVectorName( c ) << "<" << getColumnTypeName( f ) << ">& get" << f._capitalizedName << "Column();" << endl
+				<< "\tconst " << getColumnVectorName( c ) << "<" << getColumnTypeName( f ) << ">& get" << f._capitalizedName << "Column() const;" << endl;
+	}
+	_hStream << endl;
+
+	if ( c._serialized ) {
+		_hStream	<< "\t// batch serialization: the row count (an i64), then each row as " << c._name << "::serialize() writes it" << endl
+				<< "\ti64 serialize( void* buffer ) const;" << endl
+				<< "\ti64 getSerializedSize() const;" << endl
+				<< "\ti64 internalize( void* buffer );" << endl
+				<< "\ti64 internalize( const void* buffer, i64 bufferSize );" << endl
+				<< endl;
+	}
+
+	_hStream	<< "private:" << endl
+			<< endl
+			<< "\tsize_t _size;" << endl;
+	for ( const Field& f : c._fields ) {
+		_hStream << "\t" << getColumnVectorName( c ) << "<" << getColumnTypeName( f ) << "> _" << f._name << ";" << endl;
+	}
+	_hStream	<< "};" << endl
+			<< endl;
+
+	// definitions
+	TextBuffer& out = getDefinitionStream();
+	const char* specifier = getDefinitionSpecifier();
+
+	writeColumnsRowDefinitions( c, false );
+	writeColumnsRowDefinitions( c, true );
+
+	out	<< specifier << "size_t " << columns << "::size() const {" << endl
+		<< "\treturn _size;" << endl
+		<< "}" << endl
+		<< endl;
+
+	out	<< specifier << "bool " << columns << "::empty() const {" << endl
+		<< "\treturn _size == 0;" << endl
+		<< "}" << endl
+		<< endl;
+
+	out << specifier << "void " << columns << "::reserve( size_t capacity ) {" << endl;
+	for ( const Field& f : c._fields ) {
+		out << "\t_" << f._name << ".reserve( capacity );" << endl;
+	}
+	out	<< "}" << endl
+		<< endl;
+
+	out << specifier << "void " << columns << "::clear() {" << endl;
+	for ( const Field& f : c._fields ) {
+		out << "\t_" << f._name << ".clear();" << endl;
+	}
+	out	<< "\t_size = 0;" << endl
+		<< "}" << endl
+		<< endl;
+
+	// push_back (copy)
+	out << specifier << "void " << columns << "::push_back( const " << c._name << "& value ) {" << endl;
+	for ( const Field& f : c._fields ) {
+		if ( isByteArray( f )) {
+			out	<< "\t_" << f._name << ".emplace_back();" << endl
+				<< "\t_" << f._name << ".back().copyFrom( value.get" << f._capitalizedName << "() );" << endl;
+		} else {
+			out << "\t_" << f._name << ".push_back( value.get" << f._capitalizedName << "() );" << endl;
+		}
+	}
+	out	<< "\t_size++;" << endl
+		<< "}" << endl
+		<< endl;
+
+	// push_back (move): cold fields are copied through const access, as the non-const getters would
+	// allocate the cold part of a value which doesn't have one
+	out << specifier << "void " << columns << "::push_back( " << c._name << "&& value ) {" << endl;
+	for ( const Field& f : c._fields ) {
+		bool movable = isByteArray( f ) || f._dataType == DataType::STRING || f._dataType == DataType::BLOB || f._dataType == DataType::OBJECT;
+		if ( f._cold && movable ) {
+			string constValue = "static_cast<const " + c._name.str() + "&>( value )";
+			if ( isByteArray( f )) {
+				out	<< "\t_" << f._name << ".emplace_back();" << endl
+					<< "\t_" << f._name << ".back().copyFrom( " << constValue << ".get" << f._capitalizedName << "() );" << endl;
+			} else {
+				out << "\t_" << f._name << ".push_back( " << constValue << ".get" << f._capitalizedName << "() );" << endl;
+			}
+		} else if ( isByteArray( f )) {
+			out	<< "\t_" << f._name << ".emplace_back();" << endl
+				<< "\t_" << f._name << ".back().swap( value.get" << f._capitalizedName << "() );" << endl;
+		} else if ( movable ) {
+			out << "\t_" << f._name << ".push_back( std::move( value.get" << f._capitalizedName << "() ));" << endl;
+		} else {
+			out << "\t_" << f._name << ".push_back( value.get" << f._capitalizedName << "() );" << endl;
+		}
+	}
+	out	<< "\t_size++;" << endl
+		<< "}" << endl
+		<< endl;
+
+	// get
+	out	<< specifier << c._name << " " << columns << "::get( size_t index ) const {" << endl
+		<< "\t" << c._name << " value;" << endl;
+	for ( const Field& f : c._fields ) {
+		if ( isByteArray( f )) {
+			out << "\tvalue.get" << f._capitalizedName << "().copyFrom( _" << f._name << "[index] );" << endl;
+		} else if ( f._dataType == DataType::BLOB ) {
+			out << "\tvalue.get" << f._capitalizedName << "() = _" << f._name << "[index];" << endl;
+		} else {
+			out << "\tvalue.set" << f._capitalizedName << "( _" << f._name << "[index] );" << endl;
+		}
+	}
+	out	<< "\treturn value;" << endl
+		<< "}" << endl
+		<< endl;
+
+	// row views
+	out	<< specifier << columns << "::Row " << columns << "::operator[]( size_t index ) {" << endl
+		<< "\treturn Row( *this, index );" << endl
+		<< "}" << endl
+		<< endl;
+
+	out	<< specifier << columns << "::ConstRow " << columns << "::operator[]( size_t index ) const {" << endl
+		<< "\treturn ConstRow( *this, index );" << endl
+		<< "}" << endl
+		<< endl;
+
+	// columns
+	for ( const Field& f : c._fields ) {
+		out	<< specifier << getColumnVectorName( c ) << "<" << getColumnTypeName( f ) << ">& " << columns << "::get" << f._capitalizedName << "Column() {" << endl
+			<< "\treturn _" << f._name << ";" << endl
+			<< "}" << endl
+			<< endl;
+
+		out	<< specifier << "const " << getColumnVectorName( c ) << "<" << getColumnTypeName( f ) << ">& " << columns << "::get" << f._capitalizedName << "Column() const {" << endl
+			<< "\treturn _" << f._name << ";" << endl
+			<< "}" << endl
+			<< endl;
+	}
+
+	if ( c._serialized ) {
+		writeColumnsSerializationDefinitions( c );
+	}
+}
+
+// writeColumnsRowDeclaration
+void CPPClassGenerator::writeColumnsRowDeclaration( const Class& c, bool isConst ) {
+
+	string columns = c._name.str() + "Columns";
+	const char* rowName = isConst ? "ConstRow" : "Row";
+	const char* columnsRef = isConst ? "const " : "";
+
+	_hStream	<< "\t// view of a single " << (isConst ? "const " : "") << "row, with the same accessors as " << c._name << endl
+			<< "\tclass " << rowName << " {" << endl
+			<< endl
+			<< "\tpublic:" << endl
+			<< endl
+			<< "\t\t" << rowName << "( " << columnsRef << columns << "& columns, size_t index ) : _columns(columns), _index(index) {}" << endl
+			<< endl;
+
+	for ( const Field& f : c._fields ) {
+
+		const Symbol& capitalized = f._capitalizedName;
+		string typeName = getFieldTypeName( f );
+
+		if ( isPrimitive( f )) {
+			_hStream << "\t\t" << typeName << " get" << capitalized << "() const;" << endl;
+			if ( ! isConst ) {
+				_hStream << "\t\tvoid set" << capitalized << "( " << typeName << " value ) const;" << endl;
+			}
+		} else if ( isConst ) {
+			_hStream << "\t\tconst " << typeName << "& get" << capitalized << "() const;" << endl;
+		} else {
+			_hStream << "\t\t" << typeName << "& get" << capitalized << "() const;" << endl;
+		}
+	}
+
+	_hStream	<< endl
+			<< "\tprivate:" << endl
+			<< endl
+			<< "\t\t" << columnsRef << columns << "& _columns;" << endl
+			<< "\t\tsize_t _index;" << endl
+			<< "\t};" << endl;
+}
+
+// writeColumnsRowDefinitions
+void CPPClassGenerator::writeColumnsRowDefinitions( const Class& c, bool isConst ) {
+
+	TextBuffer& out = getDefinitionStream();
+	const char* specifier = getDefinitionSpecifier();
+
+	string row = c._name.str() + "Columns::" + (isConst ? "ConstRow" : "Row");
+
+	for ( const Field& f : c._fields ) {
+
+		const Symbol& capitalized = f._capitalizedName;
+		string typeName = getFieldTypeName( f );
+
+		if ( f._dataType == DataType::BOOLEAN ) {
+			out	<< specifier << "bool " << row << "::get" << capitalized << "() const {" << endl
+				<< "\treturn _columns._" << f._name << "[_index] != 0;" << endl
+				<< "}" << endl
+				<< endl;
+		} else if ( isPrimitive( f )) {
+			out	<< specifier << typeName << " " << row << "::get" << capitalized << "() const {" << endl
+				<< "\treturn _columns._" << f._name << "[_index];" << endl
+				<< "}" << endl
+				<< endl;
+		} else {
+			out	<< specifier << (isConst ? "const " : "") << typeName << "& " << row << "::get" << capitalized << "() const {" << endl
+				<< "\treturn _columns._" << f._name << "[_index];" << endl
+				<< "}" << endl
+				<< endl;
+		}
+
+		if ( isPrimitive( f ) && ! isConst ) {
+			out	<< specifier << "void " << row << "::set" << capitalized << "( " << typeName << " value ) const {" << endl
+				<< "\t_columns._" << f._name << "[_index] = value;" << endl
+				<< "}" << endl
+				<< endl;
+		}
+	}
+}
+
+// writeColumnsSerializationDefinitions
+void CPPClassGenerator::writeColumnsSerializationDefinitions( const Class& c ) {
+
+	string columns = c._name.str() + "Columns";
+
+	// serialize
+	_cppStream	<< "i64 " << columns << "::serialize( void* buffer ) const {" << endl
+				<< "\ti64 written = LittleEndian::write( buffer, (i64)_size );" << endl
+				<< "\tfor ( size_t i = 0; i < _size; i++ ) {" << endl;
+
+	bool packedBoolsWritten = false;
+	forEachSerializedField( c, [this, &c, &packedBoolsWritten]( const Field& f ) {
+		if ( f._bitIndex >= 0 ) {
+			if ( ! packedBoolsWritten ) {
+				writeColumnsPackedBools( c, false );
+				packedBoolsWritten = true;
+			}
+		} else if ( f._dataType == DataType::OBJECT ) {
+			_cppStream << "\t\twritten += _" << f._name << "[i].serialize( ((char*)buffer + written) );" << endl;
+		} else if ( isSerializedAsBytes( f )) {
+			writeSerializeBytes( _cppStream, "_" + f._name.str() + "[i]", "\t\t" );
+		} else if ( isByteArray( f )) {
+			_cppStream << "\t\twritten += Serialization::write( ((char*)buffer + written), _" << f._name << "[i] );" << endl;
+		} else if ( f._varint ) {
+			_cppStream << "\t\twritten += Varint::write( ((char*)buffer + written), " << getVarintValue( f, "_" + f._name.str() + "[i]" ) << " );" << endl;
+		} else if ( f._dataType == DataType::BOOLEAN ) {
+			_cppStream << "\t\twritten += LittleEndian::write( ((char*)buffer + written), _" << f._name << "[i] != 0 );" << endl;
+		} else {
+			_cppStream << "\t\twritten += LittleEndian::write( ((char*)buffer + written), _" << f._name << "[i] );" << endl;
+		}
+	} );
+
+	_cppStream	<< "\t}" << endl
+				<< "\treturn written;" << endl
+				<< "}" << endl
+				<< endl;
+
+	// getSerializedSize: fixed size fields are counted per column rather than per row
+	_cppStream	<< "i64 " << columns << "::getSerializedSize() const {" << endl
+				<< "\ti64 size = sizeof( i64 );" << endl;
+
+	bool packedBoolsCounted = false;
+	forEachSerializedField( c, [this, &c, &packedBoolsCounted]( const Field& f ) {
+		if ( f._bitIndex >= 0 ) {
+			if ( ! packedBoolsCounted ) {
+				for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+					if ( getSerializedPackedBoolBits( c, i ) != 0 ) {
+						_cppStream << "\tsize += (i64)_size * sizeof( " << getPackedBoolWordType( c ) << " ); // packed bools" << endl;
+					}
+				}
+				packedBoolsCounted = true;
+			}
+		} else if ( isPrimitive( f ) && ! f._varint ) {
+			_cppStream << "\tsize += (i64)_size * sizeof( " << getDataTypeName( f._dataType ) << " ); // _" << f._name << endl;
+		} else {
+			_cppStream << "\tfor ( size_t i = 0; i < _size; i++ ) {" << endl;
+			if ( f._dataType == DataType::STRING ) {
+				_cppStream << "\t\tsize += sizeof( i64 ) + _" << f._name << "[i].size();" << endl;
+			} else if ( f._dataType == DataType::BLOB ) {
+				_cppStream << "\t\tsize += sizeof( i64 ) + _" << f._name << "[i]" << (f._pmr ? ".size()" : ".getSize()") << ";" << endl;
+			} else if ( f._varint ) {
+				_cppStream << "\t\tsize += Varint::getSize( " << getVarintValue( f, "_" + f._name.str() + "[i]" ) << " );" << endl;
+			} else {
+				_cppStream << "\t\tsize += _" << f._name << "[i].getSerializedSize();" << endl;
+			}
+			_cppStream << "\t}" << endl;
+		}
+	} );
+
+	_cppStream	<< "\treturn size;" << endl
+				<< "}" << endl
+				<< endl;
+
+	writeColumnsInternalize( c, false );
+	writeColumnsInternalize( c, true );
+}
+
+// writeColumnsInternalize
+void CPPClassGenerator::writeColumnsInternalize( const Class& c, bool checked ) {
+
+	string columns = c._name.str() + "Columns";
+
+	// the serialized fields of a row in wire order, with the first packed bool standing for all of
+	// the words (see writeCheckedInternalize())
+	vector<const Field*> fields;
+	bool packedBoolsAdded = false;
+	forEachSerializedField( c, [&fields, &packedBoolsAdded]( const Field& f ) {
+		if ( f._bitIndex < 0 || ! packedBoolsAdded ) {
+			fields.push_back( &f );
+			packedBoolsAdded |= f._bitIndex >= 0;
+		}
+	} );
+
+	if ( checked ) {
+
+		// every row takes at least its checked bytes, which bounds the count before the columns are
+		// resized to it
+		i64 rowSize = 0;
+		for ( const Field* f : fields ) {
+			rowSize += getCheckedFixedSize( c, *f );
+		}
+
+		_cppStream	<< "i64 " << columns << "::internalize( const void* buffer, i64 bufferSize ) {" << endl;
+		writeBoundsCheck( _cppStream, "bufferSize < " + std::to_string( sizeof( i64 )), "" );
+		_cppStream	<< "\ti64 count = 0;" << endl
+					<< "\ti64 read = LittleEndian::read( buffer, &count );" << endl;
+		if ( rowSize > 0 ) {
+			writeBoundsCheck( _cppStream, "count < 0 || count > (bufferSize - read) / " + std::to_string( rowSize ), "" );
+		} else {
+			writeBoundsCheck( _cppStream, "count < 0", "" );
+		}
+	} else {
+		_cppStream	<< "i64 " << columns << "::internalize( void* buffer ) {" << endl
+					<< "\ti64 count = 0;" << endl
+					<< "\ti64 read = LittleEndian::read( buffer, &count );" << endl;
+	}
+	_cppStream << "\t_size = (size_t)count;" << endl;
+	for ( const Field& f : c._fields ) {
+		_cppStream << "\t_" << f._name << ".resize( _size );" << endl;
+	}
+	_cppStream << "\tfor ( size_t i = 0; i < _size; i++ ) {" << endl;
+
+	// each row is checked as writeCheckedInternalize() checks an object
+	i64 runSize = checked ? getCheckedRunSize( c, fields, 0 ) : -1;
+	if ( runSize > 0 ) {
+		writeBoundsCheck( _cppStream, "bufferSize - read < " + std::to_string( runSize ), "\t" );
+	}
+
+	for ( size_t i = 0; i < fields.size(); i++ ) {
+
+		const Field& f = *fields[i];
+		string value = "_" + f._name.str() + "[i]";
+		i64 followingSize = checked ? getCheckedRunSize( c, fields, i + 1 ) : -1;
+
+		if ( f._bitIndex >= 0 ) {
+			writeColumnsPackedBools( c, true );
+		} else if ( isSerializedAsBytes( f )) {
+			writeInternalizeBytes( _cppStream, f, value, "\t\t", followingSize );
+		} else if ( isByteArray( f )) {
+			if ( checked ) {
+				_cppStream	<< "\t\t{" << endl
+							<< "\t\t\ti64 length;" << endl
+							<< "\t\t\tLittleEndian::read( ((const char*)buffer + read), &length );" << endl;
+				writeBoundsCheck( _cppStream, "length < 0 || " + getBoundsCondition( "length", sizeof( i64 ) + followingSize ), "\t\t" );
+				_cppStream	<< "\t\t}" << endl;
+			}
+			_cppStream << "\t\tread += Serialization::read( ((char*)buffer + read), " << value << " );" << endl;
+		} else if ( f._dataType == DataType::OBJECT ) {
+			if ( checked ) {
+				_cppStream	<< "\t\t{" << endl
+							<< "\t\t\ti64 size = " << value << ".internalize( ((const char*)buffer + read), bufferSize - read );" << endl;
+				writeBoundsCheck( _cppStream, getReadSizeCondition( followingSize ), "\t\t" );
+				_cppStream	<< "\t\t\tread += size;" << endl
+							<< "\t\t}" << endl;
+			} else {
+				_cppStream << "\t\tread += " << value << ".internalize( ((char*)buffer + read) );" << endl;
+			}
+		} else if ( f._varint ) {
+			writeInternalizeVarint( _cppStream, f, value, "\t\t", followingSize );
+		} else if ( f._dataType == DataType::BOOLEAN ) {
+			_cppStream	<< "\t\t{" << endl
+						<< "\t\t\tbool value;" << endl
+						<< "\t\t\tread += LittleEndian::read( ((const char*)buffer + read), &value );" << endl
+						<< "\t\t\t" << value << " = value;" << endl
+						<< "\t\t}" << endl;
+		} else {
+			_cppStream << "\t\tread += LittleEndian::read( ((const char*)buffer + read), &" << value << " );" << endl;
+		}
+	}
+
+	_cppStream	<< "\t}" << endl
+				<< "\treturn read;" << endl
+				<< "}" << endl
+				<< endl;
+}
+
+// writeColumnsPackedBools
+void CPPClassGenerator::writeColumnsPackedBools( const Class& c, bool internalize ) {
+
+	// rows carry the class's packed bool words, so the bool columns are packed (or unpacked) row by row
+	ui32 wordBits = getPackedBoolWordBits( c );
+	const char* wordType = getPackedBoolWordType( c );
+
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+
+		if ( getSerializedPackedBoolBits( c, i ) == 0 ) {
+			continue;
+		}
+
+		vector<const Field*> fields;
+		for ( const Field& f : c._fields ) {
+			if ( f._bitIndex >= 0 && f._serialized && (ui32)f._bitIndex / wordBits == i ) {
+				fields.push_back( &f );
+			}
+		}
+
+		if ( internalize ) {
+			_cppStream	<< "\t\t{" << endl
+						<< "\t\t\t" << wordType << " value;" << endl
+						<< "\t\t\tread += LittleEndian::read( ((const char*)buffer + read), &value );" << endl;
+			for ( const Field* f : fields ) {
+				_cppStream << "\t\t\t_" << f->_name << "[i] = (value & " << getPackedBoolMask( c, *f ) << ") != 0;" << endl;
+			}
+			_cppStream << "\t\t}" << endl;
+
+		} else {
+			_cppStream << "\t\twritten += LittleEndian::write( ((char*)buffer + written), (" << wordType << ")(";
+			for ( size_t j = 0; j < fields.size(); j++ ) {
+				_cppStream << (j > 0 ? " | " : "") << "(_" << fields[j]->_name << "[i] != 0 ? " << getPackedBoolMask( c, *fields[j] ) << " : 0)";
+			}
+			_cppStream << ") );" << endl;
+		}
+	}
 }
 
 };
@@ -5,11 +5,20 @@
 #include <fstream>
 #include <sstream>
 #include <ios>
+#include <chrono>
+#include <vector>
+#include <map>
+#include <set>
+#include <string.h>
+#include <utility>
 
 #include "languages/cpp/cpp_util.h"
 #include "languages/cpp/cpp_class_generator.h"
+#include "core/text_buffer.h"
 #include "cr_constants.h"
+#include "cr_globals.h"
 #include "cr_util.h"
+#include "core/log.h"
 
 using std::unique_ptr;
 using std::shared_ptr;
@@ -17,6 +26,10 @@ using std::ostream;
 using std::ofstream;
 using std::ostringstream;
 using std::endl;
+using std::vector;
+using std::pair;
+using std::map;
+using std::set;
 
 namespace cr {
 
@@ -29,9 +42,90 @@ CPPGenerator::~CPPGenerator() {
 }
 
 // generate
-void CPPGenerator::generate( shared_ptr<GenConfig> config ) {
+void CPPGenerator::generate( const vector<shared_ptr<GenConfig>>& configs, GenStats& stats ) {
 
-	for ( Class c : config->_package._classes ) {
+	if ( configs.empty() ) {
+		return;
+	}
+
+	const File& outputDir = configs.front()->_outputDir;
+
+	// classes are independent of each other, so they can be handed out to workers in any order. 
+	// They all land in the same output dir, so their names have to be unique across the batch.
+	vector<pair<shared_ptr<GenConfig>, const Class*>> classes;
+	map<string, const GenConfig*> classOwners;
+	for ( const shared_ptr<GenConfig>& config : configs ) {
+
+		if ( ! (config->_outputDir == outputDir) ) {
+			throw CRException( "All configs in a batch must share an output dir" );
+		}
+
+		for ( const Class& c : config->_package._classes ) {
+
+			auto inserted = classOwners.insert( std::make_pair( c._name, config.get() ));
+			if ( ! inserted.second ) {
+				throw CRException( "Class %s is defined in both %s and %s",
+						c._name.c_str(),
+						inserted.first->second->_inputFile.getFullPath().c_str(),
+						config->_inputFile.getFullPath().c_str() );
+			}
+
+			classes.push_back( std::make_pair( config, &c ));
+		}
+	}
+
+	// create the output dirs up front so workers don't race to mkdir them
+	File includeDir( outputDir, "include/" );
+	if ( ! includeDir.exists() ) {
+		includeDir.mkdir( true );
+	}
+	File sourceDir( outputDir, "src/" );
+	if ( ! sourceDir.exists() ) {
+		sourceDir.mkdir( true );
+	}
+
+	// (re)load fingerprints if this is a different output dir than last time
+	File fingerprintFile( outputDir, CR_FINGERPRINT_FILE_NAME );
+	if ( ! (_fingerprints.getFile() == fingerprintFile) ) {
+		_fingerprints.load( fingerprintFile );
+	}
+
+	// each worker fills in its own slot
+	size_t statsOffset = stats._classes.size();
+	stats._classes.resize( statsOffset + classes.size() );
+	vector<ui64> fingerprints( classes.size() );
+
+	// in unity mode, class sources are gathered into a few unity sources rather than written one
+	// per class, and a unity source is only skipped if all of its classes are up to date
+	bool unity = g_unityOutput != UnityOutput::NONE;
+	vector<UnityShard> shards;
+	vector<size_t> classShards( classes.size() );
+	if ( unity ) {
+		assignUnityShards( configs, sourceDir, shards );
+		map<const GenConfig*, size_t> configIndexes;
+		for ( size_t i = 0; i < configs.size(); i++ ) {
+			configIndexes[configs[i].get()] = i;
+		}
+		// hashing the name means adding or removing a class only changes its own shard
+		for ( size_t i = 0; i < classes.size(); i++ ) {
+			if ( g_unityOutput == UnityOutput::PACKAGE ) {
+				classShards[i] = configIndexes[classes[i].first.get()];
+			} else {
+				classShards[i] = hash( classes[i].second->_name.c_str() ) % shards.size();
+			}
+			shards[classShards[i]]._classes.push_back( i );
+		}
+	}
+	reportStaleUnitySources( sourceDir, shards );
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	parallelFor( classes.size(), g_jobs, [&]( size_t i ) {
+
+		auto start = Clock::now();
+
+		const shared_ptr<GenConfig>& config = classes[i].first;
+		const Class& c = *classes[i].second;
 
 		char hFilePath[128]; 
 		snprintf( hFilePath, 128, "%s.gen.h", c._name.c_str() );
@@ -39,16 +133,246 @@ void CPPGenerator::generate( shared_ptr<GenConfig> config ) {
 		char cppFilePath[128]; 
 		snprintf( cppFilePath, 128, "%s.gen.cpp", c._name.c_str() );
 
-		CPPClassGenerator generator;
-		generator.generate( 
-				config, 
-				c,
-				"include/",
-				hFilePath,
-				"src/",
-				cppFilePath );
+		ClassGenStats& classStats = stats._classes[statsOffset + i];
+		classStats._className = c._name;
+		classStats._inputFile = config->_inputFile.getFullPath();
+		classStats._outputs.resize( 2 ); // header, then source; CPPClassGenerator fills in the rest
+		classStats._outputs[0]._path = File( includeDir, hFilePath ).getFullPath();
+		classStats._outputs[1]._path = unity ? shards[classShards[i]]._file.getFullPath() : File( sourceDir, cppFilePath ).getFullPath();
+
+		// a source of the class's own, from a run without --unity, would define it a second time
+		if ( unity ) {
+			File stale( sourceDir, cppFilePath );
+			if ( stale.exists() ) {
+				stale.rm();
+				Log::i( "Removed %s, as class %s is now in %s", stale.getFullPath().c_str(), c._name.c_str(), classStats._outputs[1]._path.c_str() );
+			}
+		}
+
+		ClassLayout layout = computeClassLayout( c, c._compactLayout );
+		classStats._layoutBytes = layout._size;
+		classStats._paddingBytes = layout._padding;
+
+		if ( c._compactLayout ) {
+			ClassLayout declared = computeClassLayout( c, false );
+			Log::i( "class %s has a compact layout of %llu bytes (%llu padding); declaration order would be %llu bytes (%llu padding)",
+					c._name.c_str(), layout._size, layout._padding, declared._size, declared._padding );
+		}
+
+		// skip the class entirely if nothing that affects its output changed
+		fingerprints[i] = computeClassFingerprint( c );
+		classStats._skipped = _fingerprints.matches( c._name, fingerprints[i] )
+				&& File( classStats._outputs[0]._path ).exists()
+				&& File( classStats._outputs[1]._path ).exists();
 
+		classStats._genTimeNanos = std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - start ).count();
+	} );
+
+	// a unity source has to be regenerated whole, which includes when a class joins or leaves it, so
+	// its membership (the names of its classes, in order) is fingerprinted under its file name too
+	for ( UnityShard& shard : shards ) {
+		shard._fingerprint = hash64( shard._file.getFileName() );
+		for ( size_t i : shard._classes ) {
+			const Symbol& name = classes[i].second->_name;
+			shard._fingerprint = hash64( name.c_str(), name.size() + 1, shard._fingerprint );
+		}
+		shard._skipped = _fingerprints.matches( shard._file.getFileName(), shard._fingerprint );
+		for ( size_t i : shard._classes ) {
+			shard._skipped &= stats._classes[statsOffset + i]._skipped;
+		}
+		for ( size_t i : shard._classes ) {
+			stats._classes[statsOffset + i]._skipped = shard._skipped;
+		}
 	}
+
+	vector<unique_ptr<CPPClassGenerator>> generators( unity ? classes.size() : 0 );
+
+	parallelFor( classes.size(), g_jobs, [&]( size_t i ) {
+
+		auto start = Clock::now();
+
+		const shared_ptr<GenConfig>& config = classes[i].first;
+		const Class& c = *classes[i].second;
+
+		ClassGenStats& classStats = stats._classes[statsOffset + i];
+
+		// a unity source's size is counted for the first of its classes only
+		bool countsSource = ! unity || shards[classShards[i]]._classes.front() == i;
+
+		if ( classStats._skipped ) {
+
+			Log::f( "class files for class %s are up to date.", c._name.c_str() );
+			for ( OutputFileStats& output : classStats._outputs ) {
+				output._bytes = (&output == &classStats._outputs[1] && ! countsSource) ? 0 : File( output._path ).getSize();
+			}
+
+		} else {
+
+			char hFilePath[128]; 
+			snprintf( hFilePath, 128, "%s.gen.h", c._name.c_str() );
+
+			char cppFilePath[128]; 
+			snprintf( cppFilePath, 128, "%s.gen.cpp", c._name.c_str() );
+
+			unique_ptr<CPPClassGenerator> generator( new CPPClassGenerator( unity ));
+			generator->generate( 
+					config, 
+					c,
+					"include/",
+					hFilePath,
+					"src/",
+					cppFilePath,
+					classStats );
+
+			// keep the source for its unity source
+			if ( unity ) {
+				generators[i] = std::move( generator );
+			}
+		}
+
+		classStats._genTimeNanos += std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - start ).count();
+	} );
+
+	if ( unity ) {
+		parallelFor( shards.size(), g_jobs, [&]( size_t i ) {
+			const UnityShard& shard = shards[i];
+			if ( shard._skipped && ! shard._classes.empty() ) {
+				return;
+			}
+
+			auto start = Clock::now();
+
+			TextBuffer source;
+			writeUnitySource( source, shard, classes, generators );
+
+			bool written = source.writeTo( shard._file );
+			if ( ! shard._classes.empty() ) {
+				ClassGenStats& classStats = stats._classes[statsOffset + shard._classes.front()];
+				classStats._outputs[1]._bytes = source.size();
+				classStats._outputs[1]._written = written;
+				classStats._filesWritten += written ? 1 : 0;
+				classStats._genTimeNanos += std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - start ).count();
+			}
+		} );
+	}
+
+	for ( size_t i = 0; i < classes.size(); i++ ) {
+		_fingerprints.set( classes[i].second->_name, fingerprints[i] );
+	}
+	for ( const UnityShard& shard : shards ) {
+		_fingerprints.set( shard._file.getFileName(), shard._fingerprint );
+	}
+	_fingerprints.save();
+}
+
+// assignUnityShards
+void CPPGenerator::assignUnityShards( const vector<shared_ptr<GenConfig>>& configs, const File& sourceDir, vector<UnityShard>& shards ) {
+
+	if ( g_unityOutput == UnityOutput::SHARDS ) {
+		shards.resize( g_unityShards );
+		for ( i32 i = 0; i < g_unityShards; i++ ) {
+			shards[i]._file = File( sourceDir, "unity_" + std::to_string( i ) + ".gen.cpp" );
+		}
+		return;
+	}
+
+	// one per package, named after its input file (made unique if inputs in different dirs share a name)
+	set<string> names;
+	shards.resize( configs.size() );
+	for ( size_t i = 0; i < configs.size(); i++ ) {
+
+		string name = configs[i]->_inputFile.getFileName();
+		size_t suffixLength = strlen( CR_INPUT_FILE_SUFFIX );
+		if ( name.size() > suffixLength && name.compare( name.size() - suffixLength, suffixLength, CR_INPUT_FILE_SUFFIX ) == 0 ) {
+			name.resize( name.size() - suffixLength );
+		}
+
+		string unique = name;
+		for ( i32 n = 2; ! names.insert( unique ).second; n++ ) {
+			unique = name + "_" + std::to_string( n );
+		}
+
+		shards[i]._file = File( sourceDir, unique + ".unity.gen.cpp" );
+	}
+}
+
+// reportStaleUnitySources
+void CPPGenerator::reportStaleUnitySources( const File& sourceDir, const vector<UnityShard>& shards ) {
+
+	set<string> written;
+	for ( const UnityShard& shard : shards ) {
+		written.insert( shard._file.getFileName() );
+	}
+
+	auto endsWith = []( const string& name, const string& suffix ) {
+		return name.size() > suffix.size() && name.compare( name.size() - suffix.size(), suffix.size(), suffix ) == 0;
+	};
+
+	// (a fresh File, as sourceDir may predate the mkdir)
+	for ( const File& file : File( sourceDir.getFullPath() ).listFiles() ) {
+		const string& name = file.getFileName();
+		if ( written.count( name ) > 0 ) {
+			continue;
+		}
+
+		// unity_<N>.gen.cpp, or <input>.unity.gen.cpp; inputs may be generated into the same output dir
+		// one at a time, so another input's unity source is only stale if this run isn't per package
+		bool sharded = name.compare( 0, 6, "unity_" ) == 0 && endsWith( name, ".gen.cpp" )
+				&& name.find_first_not_of( "0123456789", 6 ) == name.size() - strlen( ".gen.cpp" );
+		bool package = endsWith( name, ".unity.gen.cpp" );
+		if ( sharded || (package && g_unityOutput != UnityOutput::PACKAGE) ) {
+			Log::w( "%s is left over from a run with a different --unity, and may define its classes a second time; delete it",
+					file.getFullPath().c_str() );
+		}
+	}
+}
+
+// writeUnitySource
+void CPPGenerator::writeUnitySource(
+			TextBuffer& source,
+			const UnityShard& shard,
+			const vector<pair<shared_ptr<GenConfig>, const Class*>>& classes,
+			const vector<unique_ptr<CPPClassGenerator>>& generators ) {
+
+	source	<< "/**" << endl
+			<< " * CodeRoller generated unity source, holding the definitions of several classes so that they" << endl
+			<< " * are compiled together. This file is automatically generated; do not modify it because it will" << endl
+			<< " * be overwritten." << endl
+			<< " *" << endl
+			<< " * CodeRoller git hash: " << GIT_HASH << endl
+			<< " * CodeRoller git branch: " << GIT_BRANCH << endl
+			<< " */" << endl
+			<< endl;
+
+	// every header is included once, ahead of all of the definitions
+	set<string> included;
+	bool serializable = false;
+	for ( size_t i : shard._classes ) {
+		for ( const string& include : generators[i]->getSourceIncludes() ) {
+			if ( included.insert( include ).second ) {
+				source << "#include \"" << include << "\"" << endl;
+			}
+		}
+		serializable |= classes[i].second->_serialized;
+	}
+	source << endl;
+
+	if ( serializable ) {
+		source	<< "using namespace cr;" << endl
+				<< endl;
+	}
+
+	for ( size_t i : shard._classes ) {
+		const TextBuffer& classSource = generators[i]->getSource();
+		source	<< "// " << classes[i].second->_name << endl
+				<< endl;
+		source.append( classSource, 0, classSource.size() );
+	}
+}
+
+// invalidate
+void CPPGenerator::invalidate( const string& className ) {
+	_fingerprints.erase( className );
 }
 
 };
@@ -1,5 +1,6 @@
 #include "languages/cpp/cpp_util.h"
 
+#include <algorithm>
 #include <memory>
 #include <iostream>
 #include <fstream>
@@ -7,7 +8,9 @@
 #include <ios>
 
 #include "cr_constants.h"
+#include "cr_globals.h"
 #include "cr_util.h"
+#include "schema_cache.h"
 
 #define HASH_MULTIPLIER 37
 
@@ -74,99 +77,277 @@ const char* getDataTypeName( DataType type ) {
 
 }
 
-// getPrivacyName
-const char* getPrivacyName( AccessPrivacy privacy ) {
+// getDataTypeSize
+ui32 getDataTypeSize( DataType type ) {
 
-	switch ( privacy ) {
+	switch ( type ) {
 
-		case AccessPrivacy::NONE:
-			return "";
+		case DataType::I8:
+		case DataType::UI8:
+		case DataType::BOOLEAN:
+			return 1;
 
-		case AccessPrivacy::PRIVATE:
-			return "private";
+		case DataType::I16:
+		case DataType::UI16:
+			return 2;
 
-		case AccessPrivacy::PROTECTED:
-			return "protected";
+		case DataType::I32:
+		case DataType::UI32:
+		case DataType::F32:
+			return 4;
 
-		case AccessPrivacy::PUBLIC:
-			return "public";
+		case DataType::I64:
+		case DataType::UI64:
+		case DataType::F64:
+			return 8;
 
 		default:
-			throw CRException( "Unrecognized AccessPrivacy" );
+			return 0;
 	}
 }
 
-// resolvePrivacy
-AccessPrivacy resolvePrivacy( const Package& p, const Class& c, const Field& f ) {
+// getFieldTypeName
+string getFieldTypeName( const Field& f ) {
+	if ( f._dataType == DataType::OBJECT ) {
+		return f._typeName.str();
+	} else if ( isFixedString( f )) {
+		return "cr::FixedString<" + std::to_string( f._maxLength ) + ">";
+	} else if ( f._pmr ) {
+		return f._dataType == DataType::BLOB ? "std::pmr::vector<uint8_t>" : "std::pmr::string";
+	} else {
+		return getDataTypeName( f._dataType );
+	}
+}
+
+// isFixedString
+bool isFixedString( const Field& f ) {
+	return f._dataType == DataType::STRING && f._maxLength > 0;
+}
+
+// getFixedStringLengthBytes
+ui32 getFixedStringLengthBytes( ui32 maxLength ) {
+	return maxLength < 0x100 ? 1 : (maxLength < 0x10000 ? 2 : 4);
+}
 
-	if ( f._memberPrivacy != AccessPrivacy::NONE ) {
-		return f._memberPrivacy;
+// getPackedBoolWordBits
+ui32 getPackedBoolWordBits( const Class& c ) {
 
-	} else if ( c._defaultMemberPrivacy != AccessPrivacy::NONE ) {
-		return c._defaultMemberPrivacy;
+	if ( c._packedBoolCount == 0 ) {
+		return 0;
+	}
 
-	} else {
-		return p._defaultMemberPrivacy;
+	ui32 bits = 8;
+	while ( bits < 64 && bits < c._packedBoolCount ) {
+		bits *= 2;
 	}
+	return bits;
 }
 
-// resolveClassSerializable
-bool resolveClassSerializable( const Package& p, const Class& c ) {
+// getPackedBoolWordCount
+ui32 getPackedBoolWordCount( const Class& c ) {
 
-	if ( c._serializable == SerializableSpecification::YES ) {
-		return true;
-	} else if ( c._serializable == SerializableSpecification::NO ) {
-		return false;
-	} else if ( p._defaultSerializable == SerializableSpecification::YES ) {
-		return true;
-	} else {
-		return false;
+	ui32 bits = getPackedBoolWordBits( c );
+	return bits == 0 ? 0 : (c._packedBoolCount + bits - 1) / bits;
+}
+
+// getPackedBoolWordType
+const char* getPackedBoolWordType( const Class& c ) {
+
+	switch ( getPackedBoolWordBits( c )) {
+
+		case 8:
+			return "uint8_t";
+
+		case 16:
+			return "uint16_t";
+
+		case 32:
+			return "uint32_t";
+
+		default:
+			return "uint64_t";
 	}
 }
 
-// resolveFieldSerializable
-bool resolveFieldSerializable( const Package& p, const Class& c, const Field& f ) {
+// getPackedBoolWordName
+string getPackedBoolWordName( const Class& c, ui32 word ) {
 
-	if ( c._serializable == SerializableSpecification::NO ) {
+	if ( getPackedBoolWordCount( c ) == 1 ) {
+		return "_packedBools";
+	}
+	return "_packedBools" + std::to_string( word );
+}
 
-		// class explicitly says no (field should not say yes)
+/**
+ * Get the size and alignment of a field's storage. Returns false if its size isn't known here
+ * (objects and blobs), in which case it is assumed to be 8 byte aligned.
+ */
+static bool getFieldStorage( const Field& f, ui64& size, ui64& alignment ) {
 
-		if ( f._serializable == SerializableSpecification::YES ) {
-			throw CRException( "Field specifiecd as serializable, but class specified as not serializable" );
-		}
-		return false;
+	switch ( f._dataType ) {
 
-	} else if ( c._serializable == SerializableSpecification::NONE 
-			&& p._defaultSerializable != SerializableSpecification::YES ) {
+		case DataType::I8:
+		case DataType::UI8:
+		case DataType::BOOLEAN:
+			size = alignment = 1;
+			return true;
 
-		// class doesn't specify, but package says yes
+		case DataType::I16:
+		case DataType::UI16:
+			size = alignment = 2;
+			return true;
 
-		if ( f._serializable == SerializableSpecification::NO ) {
-			return false;
-		} else {
+		case DataType::I32:
+		case DataType::UI32:
+		case DataType::F32:
+			size = alignment = 4;
 			return true;
-		}
 
-	} else if ( c._serializable == SerializableSpecification::YES ) {
+		case DataType::I64:
+		case DataType::UI64:
+		case DataType::F64:
+			size = alignment = 8;
+			return true;
 
-		// class explicitly says yes
+		case DataType::STRING:
+			if ( isFixedString( f )) {
+				// the length, then the chars and their terminator
+				alignment = getFixedStringLengthBytes( f._maxLength );
+				size = (alignment + f._maxLength + 1 + alignment - 1) / alignment * alignment;
+			} else {
+				size = f._pmr ? 40 : 32; // a std::pmr::string also holds its allocator
+				alignment = 8;
+			}
+			return true;
 
-		if ( f._serializable == SerializableSpecification::NO ) {
+		case DataType::BLOB:
+			if ( f._pmr ) {
+				size = 32; // a std::pmr::vector
+				alignment = 8;
+				return true;
+			}
+			size = 0;
+			alignment = 8;
 			return false;
-		} else {
-			return true;
-		}
 
-	} else {
+		default:
+			size = 0;
+			alignment = 8;
+			return false;
+	}
+}
 
-		// nothing specifies yes, so if field specifies yes, we have error, otherwise no serializable.
+// computeClassLayout
+ClassLayout computeClassLayout( const Class& c, bool compact ) {
 
-		if ( f._serializable == SerializableSpecification::YES ) {
-			throw CRException( "Field specifiecd as serializable, neither class nor package specify serialiazable" );
+	ClassLayout layout;
+	forEachField( c, [&layout]( const Field& f ) {
+		if ( f._bitIndex < 0 ) {
+			(f._cold ? layout._coldFields : layout._fields).push_back( &f );
 		}
-		return false;
+	} );
+
+	if ( compact ) {
+		auto byAlignment = []( const Field* a, const Field* b ) {
+			ui64 sizeA, alignmentA, sizeB, alignmentB;
+			getFieldStorage( *a, sizeA, alignmentA );
+			getFieldStorage( *b, sizeB, alignmentB );
+			return alignmentA > alignmentB;
+		};
+		std::stable_sort( layout._fields.begin(), layout._fields.end(), byAlignment );
+		std::stable_sort( layout._coldFields.begin(), layout._coldFields.end(), byAlignment );
+	}
+
+	// serializable classes start with the vtable pointer (unless their dispatch is static)
+	bool vtable = c._serialized && ! c._staticDispatch;
+	ui64 offset = vtable ? 8 : 0;
+	ui64 maxAlignment = vtable ? 8 : 1;
+
+	layout._padding = 0;
+	layout._exact = true;
+
+	// the cold struct pointer
+	auto addPointer = [&]() {
+		ui64 padding = (8 - (offset % 8)) % 8;
+		layout._padding += padding;
+		offset += padding + 8;
+		maxAlignment = 8;
+	};
+
+	if ( c._hasColdFields && compact ) {
+		addPointer();
+	}
+
+	for ( const Field* f : layout._fields ) {
+
+		ui64 size, alignment;
+		layout._exact &= getFieldStorage( *f, size, alignment );
+
+		ui64 padding = (alignment - (offset % alignment)) % alignment;
+		layout._padding += padding;
+		offset += padding + size;
+		maxAlignment = std::max( maxAlignment, alignment );
+	}
+
+	// packed bool words
+	ui64 wordSize = getPackedBoolWordBits( c ) / 8;
+	for ( ui32 i = 0; i < getPackedBoolWordCount( c ); i++ ) {
+		ui64 padding = (wordSize - (offset % wordSize)) % wordSize;
+		layout._padding += padding;
+		offset += padding + wordSize;
+		maxAlignment = std::max( maxAlignment, wordSize );
+	}
 
+	if ( c._hasColdFields && ! compact ) {
+		addPointer();
 	}
+
+	// the size is rounded up to the alignment (and an empty class still takes a byte)
+	ui64 tailPadding = (offset == 0) ? 1 : (maxAlignment - (offset % maxAlignment)) % maxAlignment;
+	layout._padding += tailPadding;
+	layout._size = offset + tailPadding;
+
+	return layout;
+}
+
+// getPrivacyName
+const char* getPrivacyName( AccessPrivacy privacy ) {
+
+	switch ( privacy ) {
+
+		case AccessPrivacy::NONE:
+			return "";
+
+		case AccessPrivacy::PRIVATE:
+			return "private";
+
+		case AccessPrivacy::PROTECTED:
+			return "protected";
+
+		case AccessPrivacy::PUBLIC:
+			return "public";
+
+		default:
+			throw CRException( "Unrecognized AccessPrivacy" );
+	}
+}
+
+// computeClassFingerprint
+ui64 computeClassFingerprint( const Class& c ) {
+
+	// generator version and options
+	ui8 version[] = { CR_MAJOR_VERSION, CR_MINOR_VERSION, CR_PATCH_VERSION, (ui8)g_deterministic, (ui8)g_unityOutput };
+	ui64 h = hash64( version, sizeof( version ));
+	h = hash64( &g_unityShards, sizeof( g_unityShards ), h );
+	ui64 buildHash = getBuildHash();
+	h = hash64( &buildHash, sizeof( buildHash ), h );
+
+	// everything parsed or resolved for the class and its fields
+	string encoded;
+	encodeClass( encoded, c );
+	h = hash64( encoded.data(), encoded.size(), h );
+
+	return h;
 }
 
 // hash
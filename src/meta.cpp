@@ -0,0 +1,205 @@
+#include "meta.h"
+
+#include "core/exception.h"
+#include "core/log.h"
+
+#include "cr_util.h"
+
+namespace cr {
+
+// resolvePrivacy
+AccessPrivacy resolvePrivacy( const Package& p, const Class& c, const Field& f ) {
+
+	if ( f._memberPrivacy != AccessPrivacy::NONE ) {
+		return f._memberPrivacy;
+
+	} else if ( c._defaultMemberPrivacy != AccessPrivacy::NONE ) {
+		return c._defaultMemberPrivacy;
+
+	} else {
+		return p._defaultMemberPrivacy;
+	}
+}
+
+// resolveClassSerializable
+bool resolveClassSerializable( const Package& p, const Class& c ) {
+
+	if ( c._serializable == SerializableSpecification::YES ) {
+		return true;
+	} else if ( c._serializable == SerializableSpecification::NO ) {
+		return false;
+	} else if ( p._defaultSerializable == SerializableSpecification::YES ) {
+		return true;
+	} else {
+		return false;
+	}
+}
+
+// resolveFieldSerializable
+bool resolveFieldSerializable( const Package& p, const Class& c, const Field& f ) {
+
+	if ( c._serializable == SerializableSpecification::NO ) {
+
+		// class explicitly says no (field should not say yes)
+
+		if ( f._serializable == SerializableSpecification::YES ) {
+			throw CRException( "Field specifiecd as serializable, but class specified as not serializable" );
+		}
+		return false;
+
+	} else if ( c._serializable == SerializableSpecification::NONE 
+			&& p._defaultSerializable == SerializableSpecification::YES ) {
+
+		// class doesn't specify, but package says yes
+
+		if ( f._serializable == SerializableSpecification::NO ) {
+			return false;
+		} else {
+			return true;
+		}
+
+	} else if ( c._serializable == SerializableSpecification::YES ) {
+
+		// class explicitly says yes
+
+		if ( f._serializable == SerializableSpecification::NO ) {
+			return false;
+		} else {
+			return true;
+		}
+
+	} else {
+
+		// nothing specifies yes, so if field specifies yes, we have error, otherwise no serializable.
+
+		if ( f._serializable == SerializableSpecification::YES ) {
+			throw CRException( "Field specifiecd as serializable, neither class nor package specify serialiazable" );
+		}
+		return false;
+
+	}
+}
+
+// resolveClassLayout
+FieldLayout resolveClassLayout( const Package& p, const Class& c ) {
+
+	if ( c._layout != FieldLayout::NONE ) {
+		return c._layout;
+
+	} else if ( p._defaultLayout != FieldLayout::NONE ) {
+		return p._defaultLayout;
+
+	} else {
+		return FieldLayout::DECLARATION;
+	}
+}
+
+// resolveClassAccessors
+AccessorDefinition resolveClassAccessors( const Package& p, const Class& c ) {
+
+	if ( c._accessors != AccessorDefinition::NONE ) {
+		return c._accessors;
+
+	} else if ( p._defaultAccessors != AccessorDefinition::NONE ) {
+		return p._defaultAccessors;
+
+	} else {
+		return AccessorDefinition::OUT_OF_LINE;
+	}
+}
+
+// resolveClassAllocator
+AllocatorKind resolveClassAllocator( const Package& p, const Class& c ) {
+
+	if ( c._allocator != AllocatorKind::NONE ) {
+		return c._allocator;
+
+	} else if ( p._defaultAllocator != AllocatorKind::NONE ) {
+		return p._defaultAllocator;
+
+	} else {
+		return AllocatorKind::DEFAULT;
+	}
+}
+
+// resolveClassDispatch
+SerializationDispatch resolveClassDispatch( const Package& p, const Class& c ) {
+
+	if ( c._dispatch != SerializationDispatch::NONE ) {
+		return c._dispatch;
+
+	} else if ( p._defaultDispatch != SerializationDispatch::NONE ) {
+		return p._defaultDispatch;
+
+	} else {
+		return SerializationDispatch::VIRTUAL;
+	}
+}
+
+// resolveFieldEncoding
+IntegerEncoding resolveFieldEncoding( const Class& c, const Field& f ) {
+
+	if ( f._encoding != IntegerEncoding::NONE ) {
+		return f._encoding;
+
+	} else if ( c._encoding != IntegerEncoding::NONE ) {
+		return c._encoding;
+
+	} else {
+		return IntegerEncoding::FIXED;
+	}
+}
+
+// resolvePackage
+void resolvePackage( Package& p ) {
+
+	for ( Class& c : p._classes ) {
+
+		c._serialized = resolveClassSerializable( p, c );
+		c._compactLayout = (resolveClassLayout( p, c ) == FieldLayout::COMPACT);
+		c._inlineAccessors = (resolveClassAccessors( p, c ) == AccessorDefinition::INLINE);
+		c._pmr = (resolveClassAllocator( p, c ) == AllocatorKind::PMR);
+		c._staticDispatch = c._serialized && (resolveClassDispatch( p, c ) == SerializationDispatch::STATIC);
+
+		bool hasHotFields = false;
+		for ( const Field& f : c._fields ) {
+			hasHotFields |= f._hot;
+		}
+
+		// the cold struct would be allocated from the heap, so objects allocated from a memory
+		// resource keep all of their fields inline
+		if ( hasHotFields && c._pmr ) {
+			Log::w( "class %s allocates from a memory resource, so its fields are all stored inline (hot is ignored)", c._name.c_str() );
+			hasHotFields = false;
+		}
+
+		c._hasColdFields = false;
+		c._packedBoolCount = 0;
+		for ( Field& f : c._fields ) {
+
+			string capitalized = f._name;
+			capitalized[0] = capitalize( capitalized[0] );
+			f._capitalizedName = capitalized;
+
+			f._privacy = resolvePrivacy( p, c, f );
+			if ( f._privacy == AccessPrivacy::NONE ) {
+				throw MissingAttributeException( "Must specify a root level defaultMemberPrivacy, a class defaultMemberPrivacy, or a field memberPrivacy setting" );
+			}
+
+			f._serialized = c._serialized && resolveFieldSerializable( p, c, f );
+
+			// packed bools live in words stored in the class itself, which are never cold
+			f._bitIndex = (c._packBools && f._dataType == DataType::BOOLEAN) ? (i32)c._packedBoolCount++ : -1;
+			f._cold = hasHotFields && ! f._hot && f._bitIndex < 0;
+			c._hasColdFields |= f._cold;
+
+			// a varint never makes an 8 bit integer smaller, so those stay as they are
+			f._varint = f._serialized && isInteger( f._dataType ) && f._dataType != DataType::I8
+					&& f._dataType != DataType::UI8 && resolveFieldEncoding( c, f ) == IntegerEncoding::VARINT;
+
+			f._pmr = c._pmr && ((f._dataType == DataType::STRING && f._maxLength == 0) || f._dataType == DataType::BLOB);
+		}
+	}
+}
+
+};
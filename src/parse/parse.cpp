@@ -1,6 +1,7 @@
 #include "parse/parse.h"
 
 #include <vector>
+#include <fstream>
 
 #include "tinyxml2.h"
 
@@ -8,6 +9,7 @@
 #include "cr_globals.h"
 #include "cr_util.h"
 #include "languages/generator.h"
+#include "schema_cache.h"
 
 using namespace tinyxml2;
 
@@ -22,6 +24,18 @@ using namespace tinyxml2;
 #define PRIVACY_ATTRIBUTE_NAME "memberPrivacy"
 #define DEFAULT_SERIALIZABLE_ATTRIBUTE_NAME "defaultSerializable"
 #define SERIALIZABLE_ATTRIBUTE_NAME "serializable"
+#define LAYOUT_ATTRIBUTE_NAME "layout"
+#define HOT_ATTRIBUTE_NAME "hot"
+#define ACCESSORS_ATTRIBUTE_NAME "accessors"
+#define COLUMNS_ATTRIBUTE_NAME "columns"
+#define PACK_BOOLS_ATTRIBUTE_NAME "packBools"
+#define MAX_LENGTH_ATTRIBUTE_NAME "maxLength"
+#define ALLOCATOR_ATTRIBUTE_NAME "allocator"
+#define POOL_ATTRIBUTE_NAME "pool"
+#define DISPATCH_ATTRIBUTE_NAME "dispatch"
+#define ENCODING_ATTRIBUTE_NAME "encoding"
+
+#define MANIFEST_PREFIX '@'
 
 using std::vector;
 
@@ -39,12 +53,35 @@ shared_ptr<GenConfig> parseXML( const char* filename ) {
 		throw CRException( "Config file %s does not exist", filename );
 	}
 
+	config->_inputFile = configFile;
 	config->_mTime = configFile.getMTime();
 
+	string xml;
+	if ( ! configFile.readContents( xml )) {
+		throw CRException( "Failed to load XML from %s", filename );
+	}
+
+	// skip parsing entirely if the cache has this exact input
+	File cacheFile;
+	ui64 cacheKey = 0;
+	if ( g_schemaCacheDir.isValid() ) {
+		cacheFile = getSchemaCacheFile( g_schemaCacheDir, configFile );
+		cacheKey = computeSchemaCacheKey( xml.data(), xml.size() );
+		if ( loadSchemaCache( cacheFile, cacheKey, *config )) {
+			Log::f( "Loaded %s from the schema cache", filename );
+			return config;
+		}
+	}
+
 	XMLDocument doc;
-	doc.LoadFile( filename );
+	if ( doc.Parse( xml.data(), xml.size() ) != XML_SUCCESS ) {
+		throw CRException( "Failed to load XML from %s", filename );
+	}
 
 	XMLElement* root = doc.RootElement();
+	if ( ! root ) {
+		throw InvalidNodeNameException( "%s has no root node", filename );
+	}
 
 	// validate root node
 	if (( strcmp( root->Name(), ROOT_NODE_NAME )) != 0 ) {
@@ -83,6 +120,22 @@ shared_ptr<GenConfig> parseXML( const char* filename ) {
 	const char* defaultSerializableStr = root->Attribute( DEFAULT_SERIALIZABLE_ATTRIBUTE_NAME );
 	config->_package._defaultSerializable = cr::toSerializableSpecification( defaultSerializableStr );
 
+	// layout
+	const char* defaultLayoutStr = root->Attribute( LAYOUT_ATTRIBUTE_NAME );
+	config->_package._defaultLayout = toFieldLayout( defaultLayoutStr );
+
+	// accessors
+	const char* defaultAccessorsStr = root->Attribute( ACCESSORS_ATTRIBUTE_NAME );
+	config->_package._defaultAccessors = toAccessorDefinition( defaultAccessorsStr );
+
+	// allocator
+	const char* defaultAllocatorStr = root->Attribute( ALLOCATOR_ATTRIBUTE_NAME );
+	config->_package._defaultAllocator = toAllocatorKind( defaultAllocatorStr );
+
+	// dispatch
+	const char* defaultDispatchStr = root->Attribute( DISPATCH_ATTRIBUTE_NAME );
+	config->_package._defaultDispatch = toSerializationDispatch( defaultDispatchStr );
+
 	// parse class nodes
 	XMLElement* classElement = root->FirstChildElement( CLASS_NODE_NAME );
 	while ( classElement ) {
@@ -90,9 +143,98 @@ shared_ptr<GenConfig> parseXML( const char* filename ) {
 		classElement = classElement->NextSiblingElement( CLASS_NODE_NAME );
 	}
 
+	resolvePackage( config->_package );
+
+	// a cache we can't write just means parsing again next time
+	if ( g_schemaCacheDir.isValid() ) {
+		try {
+			saveSchemaCache( cacheFile, cacheKey, *config );
+		} catch ( const CRException& e ) {
+			Log::w( "Unable to write schema cache: %s", e.what() );
+		}
+	}
+
 	return config;
 }
 
+// parseAll
+vector<shared_ptr<GenConfig>> parseAll( const list<File>& files, i32 jobs ) {
+
+	vector<const File*> fileList;
+	for ( const File& file : files ) {
+		fileList.push_back( &file );
+	}
+
+	// create the cache dir up front so workers don't race to mkdir it
+	if ( g_schemaCacheDir.isValid() && ! g_schemaCacheDir.exists() ) {
+		File cacheDir = g_schemaCacheDir;
+		cacheDir.mkdir( true );
+	}
+
+	vector<shared_ptr<GenConfig>> configs( fileList.size() );
+	parallelFor( fileList.size(), jobs, [&]( size_t i ) {
+		configs[i] = parseXML( fileList[i]->getFullPath().c_str() );
+	} );
+
+	return configs;
+}
+
+// collectInputFiles
+void collectInputFiles( const string& path, list<File>& files ) {
+
+	// manifest
+	if ( ! path.empty() && path[0] == MANIFEST_PREFIX ) {
+
+		string manifestPath = path.substr( 1 );
+		std::ifstream manifest( manifestPath );
+		if ( ! manifest ) {
+			throw CRException( "Unable to read manifest file %s", manifestPath.c_str() );
+		}
+
+		string line;
+		while ( std::getline( manifest, line )) {
+
+			// trim whitespace
+			size_t begin = line.find_first_not_of( " \t\r" );
+			if ( begin == string::npos || line[begin] == '#' ) {
+				continue;
+			}
+			size_t end = line.find_last_not_of( " \t\r" );
+
+			collectInputFiles( line.substr( begin, end - begin + 1 ), files );
+		}
+
+		return;
+	}
+
+	File file( path );
+	if ( ! file.exists() ) {
+		throw CRException( "Invalid input file %s", path.c_str() );
+	}
+
+	if ( ! file.isDir() ) {
+		files.push_back( file );
+		return;
+	}
+
+	// directory: pick up *.cr.xml files, in a stable order
+	list<File> contents = file.listFiles();
+	contents.sort();
+
+	const size_t suffixLength = strlen( CR_INPUT_FILE_SUFFIX );
+	for ( File& entry : contents ) {
+		if ( entry.isDir() ) {
+			collectInputFiles( entry.getFullPath(), files );
+		} else {
+			const string& name = entry.getFileName();
+			if ( name.size() > suffixLength
+					&& name.compare( name.size() - suffixLength, suffixLength, CR_INPUT_FILE_SUFFIX ) == 0 ) {
+				files.push_back( entry );
+			}
+		}
+	}
+}
+
 // parseClass
 Class parseClass( XMLElement* classElement ) {
 
@@ -108,6 +250,49 @@ Class parseClass( XMLElement* classElement ) {
 	const char* defaultMemberPrivacyStr = classElement->Attribute( DEFAULT_PRIVACY_ATTRIBUTE_NAME );
 	c._defaultMemberPrivacy = toAccessPrivacy( defaultMemberPrivacyStr );
 
+	// serializable
+	const char* serializableStr = classElement->Attribute( SERIALIZABLE_ATTRIBUTE_NAME );
+	c._serializable = toSerializableSpecification( serializableStr );
+	c._serialized = false;
+
+	// layout
+	const char* layoutStr = classElement->Attribute( LAYOUT_ATTRIBUTE_NAME );
+	c._layout = toFieldLayout( layoutStr );
+	c._compactLayout = false;
+	c._hasColdFields = false;
+
+	// accessors
+	const char* accessorsStr = classElement->Attribute( ACCESSORS_ATTRIBUTE_NAME );
+	c._accessors = toAccessorDefinition( accessorsStr );
+	c._inlineAccessors = false;
+
+	// allocator
+	const char* allocatorStr = classElement->Attribute( ALLOCATOR_ATTRIBUTE_NAME );
+	c._allocator = toAllocatorKind( allocatorStr );
+	c._pmr = false;
+
+	// dispatch
+	const char* dispatchStr = classElement->Attribute( DISPATCH_ATTRIBUTE_NAME );
+	c._dispatch = toSerializationDispatch( dispatchStr );
+	c._staticDispatch = false;
+
+	// encoding
+	const char* encodingStr = classElement->Attribute( ENCODING_ATTRIBUTE_NAME );
+	c._encoding = toIntegerEncoding( encodingStr );
+
+	// columns
+	const char* columnsStr = classElement->Attribute( COLUMNS_ATTRIBUTE_NAME );
+	c._columns = toBoolean( columnsStr, false );
+
+	// packBools
+	const char* packBoolsStr = classElement->Attribute( PACK_BOOLS_ATTRIBUTE_NAME );
+	c._packBools = toBoolean( packBoolsStr, false );
+	c._packedBoolCount = 0;
+
+	// pool
+	const char* poolStr = classElement->Attribute( POOL_ATTRIBUTE_NAME );
+	c._pool = toBoolean( poolStr, false );
+
 	// parse field nodes
 	XMLElement* fieldElement = classElement->FirstChildElement( FIELD_NODE_NAME );
 	while ( fieldElement ) {
@@ -124,6 +309,13 @@ Class parseClass( XMLElement* classElement ) {
 Field parseField( XMLElement* fieldElement, const Class& c ) {
 
 	Field f;
+	f._dataType = DataType::NONE;
+	f._privacy = AccessPrivacy::NONE;
+	f._serialized = false;
+	f._cold = false;
+	f._bitIndex = -1;
+	f._pmr = false;
+	f._varint = false;
 	
 	const char* fieldName = fieldElement->Attribute( NAME_ATTRIBUTE_NAME );
 	if ( ! fieldName ) {
@@ -145,7 +337,7 @@ Field parseField( XMLElement* fieldElement, const Class& c ) {
 				throw MissingAttributeException( "Invalid object type name" );
 			}
 
-			f._typeName = fieldTypeStr.substr(7); // strlen("object:")
+			f._typeName = Symbol( fieldTypeStr.substr(7) ); // strlen("object:")
 		}
 	} catch ( ... ) {
 		Log::w( "Exception caught while parsing class %s. Rethrowing.", c._name.c_str() );
@@ -156,6 +348,28 @@ Field parseField( XMLElement* fieldElement, const Class& c ) {
 	const char* memberPrivacyStr = fieldElement->Attribute( PRIVACY_ATTRIBUTE_NAME );
 	f._memberPrivacy = toAccessPrivacy( memberPrivacyStr );
 
+	// serializable
+	const char* serializableStr = fieldElement->Attribute( SERIALIZABLE_ATTRIBUTE_NAME );
+	f._serializable = toSerializableSpecification( serializableStr );
+
+	// hot
+	const char* hotStr = fieldElement->Attribute( HOT_ATTRIBUTE_NAME );
+	f._hot = toBoolean( hotStr, false );
+
+	// maxLength
+	const char* maxLengthStr = fieldElement->Attribute( MAX_LENGTH_ATTRIBUTE_NAME );
+	f._maxLength = toPositiveInteger( maxLengthStr, 0 );
+	if ( f._maxLength > 0 && f._dataType != DataType::STRING ) {
+		throw CRException( "Field %s of class %s has a maxLength, but only strings can", fieldName, c._name.c_str() );
+	}
+
+	// encoding
+	const char* encodingStr = fieldElement->Attribute( ENCODING_ATTRIBUTE_NAME );
+	f._encoding = toIntegerEncoding( encodingStr );
+	if ( f._encoding != IntegerEncoding::NONE && ! isInteger( f._dataType )) {
+		throw CRException( "Field %s of class %s has an encoding, but only integers can", fieldName, c._name.c_str() );
+	}
+
 	return f;
 }
 
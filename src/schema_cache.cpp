@@ -0,0 +1,348 @@
+#include "schema_cache.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "core/exception.h"
+#include "core/log.h"
+
+#include "cr_constants.h"
+#include "cr_util.h"
+
+#define SCHEMA_CACHE_MAGIC 0x43534352 // "RCSC" in little endian
+#define SCHEMA_CACHE_FORMAT_VERSION 11 // bump whenever the encoding changes
+
+namespace cr {
+
+/**
+ * Cache file header. The payload (the encoded package) follows immediately.
+ */
+struct SchemaCacheHeader {
+
+	ui32 _magic;
+	ui32 _formatVersion;
+	ui64 _key;
+	ui64 _payloadSize;
+	ui64 _payloadHash;
+};
+
+/**
+ * Reads the encoding back, throwing if it runs off the end of the buffer
+ */
+class SchemaReader {
+
+public:
+
+	SchemaReader( const ui8* data, size_t size ) :
+					_pos(data),
+					_end(data + size) {
+	}
+
+	ui8 readU8() {
+		require( 1 );
+		return *_pos++;
+	}
+
+	ui32 readU32() {
+		ui32 value;
+		require( sizeof( value ));
+		memcpy( &value, _pos, sizeof( value ));
+		_pos += sizeof( value );
+		return value;
+	}
+
+	Symbol readSymbol() {
+		ui32 size = readU32();
+		require( size );
+		const char* str = (const char*)_pos;
+		_pos += size;
+		return Symbol( string( str, size ));
+	}
+
+	/**
+	 * Read an enum stored as a byte, making sure it is no greater than max
+	 */
+	template<typename T>
+	T readEnum( T max ) {
+		ui8 value = readU8();
+		if ( value > (ui8)max ) {
+			throw CRException( "Invalid enum value %d in schema cache", (i32)value );
+		}
+		return (T)value;
+	}
+
+	bool atEnd() const { return _pos == _end; };
+
+private:
+
+	const ui8* _pos;
+	const ui8* _end;
+
+	void require( size_t size ) {
+		if ( (size_t)(_end - _pos) < size ) {
+			throw CRException( "Schema cache is truncated" );
+		}
+	}
+};
+
+/**
+ * Append a byte
+ */
+static void writeU8( string& out, ui8 value ) {
+	out.push_back( (char)value );
+}
+
+/**
+ * Append a 32 bit int
+ */
+static void writeU32( string& out, ui32 value ) {
+	out.append( (const char*)&value, sizeof( value ));
+}
+
+/**
+ * Append a length prefixed string
+ */
+static void writeSymbol( string& out, const Symbol& symbol ) {
+	writeU32( out, (ui32)symbol.size() );
+	out.append( symbol.c_str(), symbol.size() );
+}
+
+/**
+ * Decode a class written by encodeClass()
+ */
+static void decodeClass( SchemaReader& reader, Class& c ) {
+
+	c._name = reader.readSymbol();
+	c._defaultMemberPrivacy = reader.readEnum( AccessPrivacy::PUBLIC );
+	c._serializable = reader.readEnum( SerializableSpecification::NO );
+	c._serialized = reader.readU8() != 0;
+	c._layout = reader.readEnum( FieldLayout::COMPACT );
+	c._compactLayout = reader.readU8() != 0;
+	c._hasColdFields = reader.readU8() != 0;
+	c._accessors = reader.readEnum( AccessorDefinition::INLINE );
+	c._inlineAccessors = reader.readU8() != 0;
+	c._columns = reader.readU8() != 0;
+	c._packBools = reader.readU8() != 0;
+	c._packedBoolCount = reader.readU32();
+	c._allocator = reader.readEnum( AllocatorKind::PMR );
+	c._pmr = reader.readU8() != 0;
+	c._pool = reader.readU8() != 0;
+	c._dispatch = reader.readEnum( SerializationDispatch::STATIC );
+	c._staticDispatch = reader.readU8() != 0;
+	c._encoding = reader.readEnum( IntegerEncoding::VARINT );
+
+	c._fields.resize( reader.readU32() );
+	for ( Field& f : c._fields ) {
+		f._name = reader.readSymbol();
+		f._memberPrivacy = reader.readEnum( AccessPrivacy::PUBLIC );
+		f._dataType = reader.readEnum( DataType::BOOLEAN );
+		f._typeName = reader.readSymbol();
+		f._defaultValue = reader.readSymbol();
+		f._serializable = reader.readEnum( SerializableSpecification::NO );
+		f._capitalizedName = reader.readSymbol();
+		f._privacy = reader.readEnum( AccessPrivacy::PUBLIC );
+		f._serialized = reader.readU8() != 0;
+		f._hot = reader.readU8() != 0;
+		f._maxLength = reader.readU32();
+		f._cold = reader.readU8() != 0;
+		f._bitIndex = (i32)reader.readU32();
+		f._pmr = reader.readU8() != 0;
+		f._encoding = reader.readEnum( IntegerEncoding::VARINT );
+		f._varint = reader.readU8() != 0;
+	}
+}
+
+// encodeClass
+void encodeClass( string& out, const Class& c ) {
+
+	writeSymbol( out, c._name );
+	writeU8( out, (ui8)c._defaultMemberPrivacy );
+	writeU8( out, (ui8)c._serializable );
+	writeU8( out, c._serialized ? 1 : 0 );
+	writeU8( out, (ui8)c._layout );
+	writeU8( out, c._compactLayout ? 1 : 0 );
+	writeU8( out, c._hasColdFields ? 1 : 0 );
+	writeU8( out, (ui8)c._accessors );
+	writeU8( out, c._inlineAccessors ? 1 : 0 );
+	writeU8( out, c._columns ? 1 : 0 );
+	writeU8( out, c._packBools ? 1 : 0 );
+	writeU32( out, c._packedBoolCount );
+	writeU8( out, (ui8)c._allocator );
+	writeU8( out, c._pmr ? 1 : 0 );
+	writeU8( out, c._pool ? 1 : 0 );
+	writeU8( out, (ui8)c._dispatch );
+	writeU8( out, c._staticDispatch ? 1 : 0 );
+	writeU8( out, (ui8)c._encoding );
+
+	writeU32( out, (ui32)c._fields.size() );
+	for ( const Field& f : c._fields ) {
+		writeSymbol( out, f._name );
+		writeU8( out, (ui8)f._memberPrivacy );
+		writeU8( out, (ui8)f._dataType );
+		writeSymbol( out, f._typeName );
+		writeSymbol( out, f._defaultValue );
+		writeU8( out, (ui8)f._serializable );
+		writeSymbol( out, f._capitalizedName );
+		writeU8( out, (ui8)f._privacy );
+		writeU8( out, f._serialized ? 1 : 0 );
+		writeU8( out, f._hot ? 1 : 0 );
+		writeU32( out, f._maxLength );
+		writeU8( out, f._cold ? 1 : 0 );
+		writeU32( out, (ui32)f._bitIndex );
+		writeU8( out, f._pmr ? 1 : 0 );
+		writeU8( out, (ui8)f._encoding );
+		writeU8( out, f._varint ? 1 : 0 );
+	}
+}
+
+// getSchemaCacheFile
+File getSchemaCacheFile( const File& cacheDir, const File& inputFile ) {
+
+	// one cache per input path
+	char fileName[32];
+	snprintf( fileName, sizeof( fileName ), "%016llx.bin", hash64( inputFile.getFullPath() ));
+	return File( cacheDir, fileName );
+}
+
+// computeSchemaCacheKey
+ui64 computeSchemaCacheKey( const char* xml, size_t size ) {
+
+	ui8 version[] = { CR_MAJOR_VERSION, CR_MINOR_VERSION, CR_PATCH_VERSION, SCHEMA_CACHE_FORMAT_VERSION };
+	ui64 h = hash64( version, sizeof( version ));
+	ui64 buildHash = getBuildHash();
+	h = hash64( &buildHash, sizeof( buildHash ), h );
+	return hash64( xml, size, h );
+}
+
+// loadSchemaCache
+bool loadSchemaCache( const File& cacheFile, ui64 key, GenConfig& config ) {
+
+	i32 fd = open( cacheFile.getFullPath().c_str(), O_RDONLY );
+	if ( fd < 0 ) {
+		return false;
+	}
+
+	struct stat fileStats;
+	if ( fstat( fd, &fileStats ) != 0 || (size_t)fileStats.st_size < sizeof( SchemaCacheHeader )) {
+		close( fd );
+		return false;
+	}
+
+	size_t size = (size_t)fileStats.st_size;
+	void* mapping = mmap( nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	close( fd );
+	if ( mapping == MAP_FAILED ) {
+		return false;
+	}
+
+	const ui8* data = (const ui8*)mapping;
+
+	SchemaCacheHeader header;
+	memcpy( &header, data, sizeof( header ));
+
+	bool loaded = false;
+	if ( header._magic == SCHEMA_CACHE_MAGIC
+			&& header._formatVersion == SCHEMA_CACHE_FORMAT_VERSION
+			&& header._key == key
+			&& header._payloadSize == size - sizeof( header )
+			&& header._payloadHash == hash64( data + sizeof( header ), (size_t)header._payloadSize )) {
+
+		// decode into a scratch package so that a bad cache leaves the config alone
+		Package package;
+		list<Language> languages;
+		try {
+			SchemaReader reader( data + sizeof( header ), header._payloadSize );
+
+			package._defaultMemberPrivacy = reader.readEnum( AccessPrivacy::PUBLIC );
+			package._defaultSerializable = reader.readEnum( SerializableSpecification::NO );
+			package._defaultLayout = reader.readEnum( FieldLayout::COMPACT );
+			package._defaultAccessors = reader.readEnum( AccessorDefinition::INLINE );
+			package._defaultAllocator = reader.readEnum( AllocatorKind::PMR );
+			package._defaultDispatch = reader.readEnum( SerializationDispatch::STATIC );
+
+			ui32 languageCount = reader.readU32();
+			for ( ui32 i = 0; i < languageCount; i++ ) {
+				languages.push_back( reader.readEnum( Language::CPP ));
+			}
+
+			package._classes.resize( reader.readU32() );
+			for ( Class& c : package._classes ) {
+				decodeClass( reader, c );
+			}
+
+			loaded = reader.atEnd();
+
+		} catch ( const CRException& e ) {
+			Log::w( "Ignoring schema cache %s: %s", cacheFile.getFullPath().c_str(), e.what() );
+		}
+
+		if ( loaded ) {
+			config._package = std::move( package );
+			config._languages = std::move( languages );
+		}
+	}
+
+	munmap( mapping, size );
+	return loaded;
+}
+
+// saveSchemaCache
+void saveSchemaCache( const File& cacheFile, ui64 key, const GenConfig& config ) {
+
+	string data( sizeof( SchemaCacheHeader ), 0x00 );
+
+	const Package& package = config._package;
+	writeU8( data, (ui8)package._defaultMemberPrivacy );
+	writeU8( data, (ui8)package._defaultSerializable );
+	writeU8( data, (ui8)package._defaultLayout );
+	writeU8( data, (ui8)package._defaultAccessors );
+	writeU8( data, (ui8)package._defaultAllocator );
+	writeU8( data, (ui8)package._defaultDispatch );
+
+	writeU32( data, (ui32)config._languages.size() );
+	for ( Language language : config._languages ) {
+		writeU8( data, (ui8)language );
+	}
+
+	writeU32( data, (ui32)package._classes.size() );
+	for ( const Class& c : package._classes ) {
+		encodeClass( data, c );
+	}
+
+	SchemaCacheHeader header;
+	header._magic = SCHEMA_CACHE_MAGIC;
+	header._formatVersion = SCHEMA_CACHE_FORMAT_VERSION;
+	header._key = key;
+	header._payloadSize = data.size() - sizeof( header );
+	header._payloadHash = hash64( data.data() + sizeof( header ), (size_t)header._payloadSize );
+	memcpy( &data[0], &header, sizeof( header ));
+
+	// write to a temp file and rename it over the cache
+	string path = cacheFile.getFullPath();
+	char tempSuffix[32];
+	snprintf( tempSuffix, sizeof( tempSuffix ), ".%d.tmp", (i32)getpid() );
+	string tempPath = path + tempSuffix;
+
+	FILE* out = fopen( tempPath.c_str(), "wb" );
+	if ( ! out ) {
+		throw CRException( "Failed to open %s for writing: %s", tempPath.c_str(), strerror( errno ));
+	}
+
+	size_t written = fwrite( data.data(), 1, data.size(), out );
+	if ( fclose( out ) != 0 || written != data.size() ) {
+		remove( tempPath.c_str() );
+		throw CRException( "Failed to write %s", tempPath.c_str() );
+	}
+
+	if ( rename( tempPath.c_str(), path.c_str() ) != 0 ) {
+		remove( tempPath.c_str() );
+		throw CRException( "Failed to rename %s to %s: %s", tempPath.c_str(), path.c_str(), strerror( errno ));
+	}
+}
+
+}
@@ -0,0 +1,221 @@
+#include "stats_report.h"
+
+#include <string.h>
+#include <sstream>
+
+#include "core/exception.h"
+
+#include "cr_constants.h"
+#include "cr_globals.h"
+#include "cr_util.h"
+
+using std::ostringstream;
+
+namespace cr {
+
+/**
+ * Totals over every class in a run
+ */
+struct StatsTotals {
+
+	i32 _classesSkipped;
+	i32 _filesWritten;
+	i32 _filesUpToDate;
+	ui64 _bytesGenerated;
+};
+
+/**
+ * Sum up the per-class stats
+ */
+static StatsTotals computeTotals( const GenStats& stats ) {
+
+	StatsTotals totals = {};
+	for ( const ClassGenStats& classStats : stats._classes ) {
+		totals._classesSkipped += classStats._skipped ? 1 : 0;
+		for ( const OutputFileStats& output : classStats._outputs ) {
+			totals._bytesGenerated += output._bytes;
+			if ( output._written ) {
+				totals._filesWritten++;
+			} else {
+				totals._filesUpToDate++;
+			}
+		}
+	}
+
+	return totals;
+}
+
+/**
+ * Write a JSON string literal
+ */
+static void writeJSONString( ostringstream& stream, const string& str ) {
+
+	stream << '"';
+	for ( char c : str ) {
+		if ( c == '"' || c == '\\' ) {
+			stream << '\\' << c;
+		} else if ( (unsigned char)c < 0x20 ) {
+			char escaped[8];
+			snprintf( escaped, sizeof( escaped ), "\\u%04x", (unsigned char)c );
+			stream << escaped;
+		} else {
+			stream << c;
+		}
+	}
+	stream << '"';
+}
+
+/**
+ * Write a CSV field, quoting it if needed
+ */
+static void writeCSVField( ostringstream& stream, const string& str ) {
+
+	if ( str.find_first_of( ",\"\r\n" ) == string::npos ) {
+		stream << str;
+		return;
+	}
+
+	stream << '"';
+	for ( char c : str ) {
+		if ( c == '"' ) {
+			stream << '"';
+		}
+		stream << c;
+	}
+	stream << '"';
+}
+
+/**
+ * Format the report as JSON
+ */
+static string formatJSON( ui64 parseTimeNanos, ui64 genTimeNanos, size_t inputFiles, const GenStats& stats ) {
+
+	StatsTotals totals = computeTotals( stats );
+
+	ostringstream stream;
+	stream << "{\n";
+	stream << "\t\"version\": \"" << CR_MAJOR_VERSION << "." << CR_MINOR_VERSION << "." << CR_PATCH_VERSION << "\",\n";
+	stream << "\t\"jobs\": " << g_jobs << ",\n";
+	stream << "\t\"inputFiles\": " << inputFiles << ",\n";
+	stream << "\t\"parseTimeNanos\": " << parseTimeNanos << ",\n";
+	stream << "\t\"genTimeNanos\": " << genTimeNanos << ",\n";
+	stream << "\t\"totalTimeNanos\": " << (parseTimeNanos + genTimeNanos) << ",\n";
+	stream << "\t\"peakMemoryBytes\": " << getPeakMemoryBytes() << ",\n";
+	stream << "\t\"classCount\": " << stats._classes.size() << ",\n";
+	stream << "\t\"classesSkipped\": " << totals._classesSkipped << ",\n";
+	stream << "\t\"filesWritten\": " << totals._filesWritten << ",\n";
+	stream << "\t\"filesUpToDate\": " << totals._filesUpToDate << ",\n";
+	stream << "\t\"bytesGenerated\": " << totals._bytesGenerated << ",\n";
+	stream << "\t\"classes\": [";
+
+	for ( size_t i = 0; i < stats._classes.size(); i++ ) {
+
+		const ClassGenStats& classStats = stats._classes[i];
+
+		stream << (i > 0 ? ",\n" : "\n");
+		stream << "\t\t{\n";
+		stream << "\t\t\t\"name\": ";
+		writeJSONString( stream, classStats._className );
+		stream << ",\n";
+		stream << "\t\t\t\"input\": ";
+		writeJSONString( stream, classStats._inputFile );
+		stream << ",\n";
+		stream << "\t\t\t\"genTimeNanos\": " << classStats._genTimeNanos << ",\n";
+		stream << "\t\t\t\"writeTimeNanos\": " << classStats._writeTimeNanos << ",\n";
+		stream << "\t\t\t\"layoutBytes\": " << classStats._layoutBytes << ",\n";
+		stream << "\t\t\t\"paddingBytes\": " << classStats._paddingBytes << ",\n";
+		stream << "\t\t\t\"skipped\": " << (classStats._skipped ? "true" : "false") << ",\n";
+		stream << "\t\t\t\"files\": [";
+
+		for ( size_t j = 0; j < classStats._outputs.size(); j++ ) {
+
+			const OutputFileStats& output = classStats._outputs[j];
+
+			stream << (j > 0 ? ", " : "") << "{ \"path\": ";
+			writeJSONString( stream, output._path );
+			stream << ", \"bytes\": " << output._bytes;
+			stream << ", \"written\": " << (output._written ? "true" : "false") << " }";
+		}
+
+		stream << "]\n";
+		stream << "\t\t}";
+	}
+
+	stream << (stats._classes.empty() ? "]\n" : "\n\t]\n");
+	stream << "}\n";
+
+	return stream.str();
+}
+
+/**
+ * Format the report as CSV. Run totals are on the "run,totals" row: bytes generated, classes
+ * skipped and files written. Class rows also carry the estimated size and padding of the class.
+ */
+static string formatCSV( ui64 parseTimeNanos, ui64 genTimeNanos, const GenStats& stats ) {
+
+	StatsTotals totals = computeTotals( stats );
+
+	ostringstream stream;
+	stream << "record,name,input,path,nanos,bytes,skipped,written,layout_bytes,padding_bytes\n";
+	stream << "phase,parse,,," << parseTimeNanos << ",,,,,\n";
+	stream << "phase,generate,,," << genTimeNanos << ",,,,,\n";
+	stream << "phase,total,,," << (parseTimeNanos + genTimeNanos) << ",,,,,\n";
+	stream << "run,peak_memory,,,," << getPeakMemoryBytes() << ",,,,\n";
+	stream << "run,totals,,,," << totals._bytesGenerated << "," << totals._classesSkipped << "," << totals._filesWritten << ",,\n";
+
+	for ( const ClassGenStats& classStats : stats._classes ) {
+
+		stream << "class,";
+		writeCSVField( stream, classStats._className );
+		stream << ",";
+		writeCSVField( stream, classStats._inputFile );
+		stream << ",," << classStats._genTimeNanos << ",," << (classStats._skipped ? 1 : 0) << "," << classStats._filesWritten
+				<< "," << classStats._layoutBytes << "," << classStats._paddingBytes << "\n";
+
+		for ( const OutputFileStats& output : classStats._outputs ) {
+			stream << "file,";
+			writeCSVField( stream, classStats._className );
+			stream << ",";
+			writeCSVField( stream, classStats._inputFile );
+			stream << ",";
+			writeCSVField( stream, output._path );
+			stream << ",," << output._bytes << "," << (classStats._skipped ? 1 : 0) << "," << (output._written ? 1 : 0) << ",,\n";
+		}
+	}
+
+	return stream.str();
+}
+
+// toStatsFormat
+StatsFormat toStatsFormat( const char* str ) {
+
+	if ( strcmp( str, "json" ) == 0 ) {
+		return StatsFormat::JSON;
+
+	} else if ( strcmp( str, "csv" ) == 0 ) {
+		return StatsFormat::CSV;
+
+	} else {
+		throw CRException( "Unrecognized stats format: %s", str );
+	}
+}
+
+// formatStatsReport
+string formatStatsReport(
+		StatsFormat format,
+		ui64 parseTimeNanos,
+		ui64 genTimeNanos,
+		size_t inputFiles,
+		const GenStats& stats ) {
+
+	switch ( format ) {
+		case StatsFormat::JSON:
+			return formatJSON( parseTimeNanos, genTimeNanos, inputFiles, stats );
+		case StatsFormat::CSV:
+			return formatCSV( parseTimeNanos, genTimeNanos, stats );
+		default:
+			return string();
+	}
+}
+
+}
@@ -0,0 +1,276 @@
+#include "watch.h"
+
+#include <set>
+#include <map>
+#include <string>
+#include <chrono>
+#include <errno.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+
+#include "core/log.h"
+#include "core/exception.h"
+
+#include "cr_globals.h"
+#include "depfile.h"
+#include "generate.h"
+#include "parse/parse.h"
+
+// how long to wait for more events after the first one, so that a burst of writes (e.g. an editor
+// saving) results in a single regeneration
+#define WATCH_SETTLE_MILLIS 50
+
+#define WATCH_EVENT_MASK (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+using std::set;
+using std::map;
+using std::pair;
+using std::string;
+
+namespace cr {
+
+/**
+ * Collect the names of all classes which depend (directly or through other classes) on any of the
+ * given classes through object fields.
+ */
+static set<string> findDependents( const vector<shared_ptr<GenConfig>>& configs, const set<string>& changed ) {
+
+	// type name -> classes with a field of that type
+	map<string, set<string>> dependents;
+	for ( const shared_ptr<GenConfig>& config : configs ) {
+		for ( const Class& c : config->_package._classes ) {
+			for ( const Field& f : c._fields ) {
+				if ( f._dataType == DataType::OBJECT ) {
+					dependents[f._typeName].insert( c._name );
+				}
+			}
+		}
+	}
+
+	set<string> result;
+	vector<string> pending( changed.begin(), changed.end() );
+	while ( ! pending.empty() ) {
+
+		string name = pending.back();
+		pending.pop_back();
+
+		auto itr = dependents.find( name );
+		if ( itr == dependents.end() ) {
+			continue;
+		}
+
+		for ( const string& dependent : itr->second ) {
+			if ( changed.count( dependent ) == 0 && result.insert( dependent ).second ) {
+				pending.push_back( dependent );
+			}
+		}
+	}
+
+	return result;
+}
+
+/**
+ * Update outputs (the stats of every class of the configs, as of its last generation) with the stats
+ * of a regeneration, dropping the classes which no longer exist, and rewrite the depfile and manifest
+ * from it.
+ */
+static void updateOutputs( const vector<shared_ptr<GenConfig>>& configs, GenStats& outputs, const GenStats& stats ) {
+
+	// keyed by input and class name, as a class being moved between inputs may briefly be in both. A
+	// class regenerated twice (as changed, then as a dependent) is listed twice; the last one wins
+	map<pair<string, string>, ClassGenStats> latest;
+	for ( const ClassGenStats& classStats : outputs._classes ) {
+		latest[std::make_pair( classStats._inputFile, classStats._className )] = classStats;
+	}
+	for ( const ClassGenStats& classStats : stats._classes ) {
+		latest[std::make_pair( classStats._inputFile, classStats._className )] = classStats;
+	}
+
+	outputs._classes.clear();
+	for ( const shared_ptr<GenConfig>& config : configs ) {
+		for ( const Class& c : config->_package._classes ) {
+			auto itr = latest.find( std::make_pair( config->_inputFile.getFullPath(), c._name.str() ));
+			if ( itr != latest.end() ) {
+				outputs._classes.push_back( itr->second );
+			}
+		}
+	}
+
+	if ( g_depfile.isValid() ) {
+		writeDepfile( g_depfile, outputs );
+	}
+	if ( g_outputManifest.isValid() ) {
+		writeOutputManifest( g_outputManifest, outputs );
+	}
+}
+
+/**
+ * Re-parse and regenerate the given configs (by index)
+ */
+static void regenerate( vector<shared_ptr<GenConfig>>& configs, const set<size_t>& changedConfigs, GenStats& outputs ) {
+
+	typedef std::chrono::high_resolution_clock Clock;
+	auto start = Clock::now();
+
+	// re-parse changed files; on error keep the last good config around
+	vector<shared_ptr<GenConfig>> reparsed;
+	for ( size_t index : changedConfigs ) {
+		try {
+			shared_ptr<GenConfig> config = parseXML( configs[index]->_inputFile.getFullPath().c_str() );
+			config->_outputDir = configs[index]->_outputDir;
+			configs[index] = config;
+			reparsed.push_back( config );
+		} catch ( const exception& e ) {
+			Log::e( "Failed to parse %s: %s", configs[index]->_inputFile.getFullPath().c_str(), e.what() );
+		}
+	}
+
+	if ( reparsed.empty() ) {
+		return;
+	}
+
+	// classes whose fingerprint didn't change are skipped by the generators. A unity source holds
+	// classes from several inputs and is written whole, so in unity mode every config is passed.
+	bool unity = g_unityOutput != UnityOutput::NONE;
+	GenStats stats;
+	set<string> changedClasses;
+	set<string> dependents;
+
+	// an input which is fine on its own can still fail to generate along with the others (e.g. a class
+	// being moved between inputs is briefly defined in both), so errors are logged and watching goes on
+	try {
+		generateAll( unity ? configs : reparsed, stats );
+
+		for ( const ClassGenStats& classStats : stats._classes ) {
+			if ( ! classStats._skipped ) {
+				changedClasses.insert( classStats._className );
+			}
+		}
+
+		// regenerate the dependents of changed classes, and only those
+		dependents = findDependents( configs, changedClasses );
+		if ( ! dependents.empty() ) {
+
+			vector<shared_ptr<GenConfig>> dependentConfigs;
+			for ( const shared_ptr<GenConfig>& config : configs ) {
+				for ( const Class& c : config->_package._classes ) {
+					if ( dependents.count( c._name ) > 0 ) {
+						dependentConfigs.push_back( config );
+						break;
+					}
+				}
+			}
+
+			for ( const string& name : dependents ) {
+				invalidateAll( name );
+			}
+
+			generateAll( unity ? configs : dependentConfigs, stats );
+		}
+
+		updateOutputs( configs, outputs, stats );
+
+	} catch ( const exception& e ) {
+		Log::e( "Failed to regenerate: %s", e.what() );
+		return;
+	}
+
+	i32 filesWritten = 0;
+	for ( const ClassGenStats& classStats : stats._classes ) {
+		filesWritten += classStats._filesWritten;
+	}
+
+	double seconds = (double)std::chrono::duration_cast<std::chrono::nanoseconds>( Clock::now() - start ).count() / 1000000000.0;
+	Log::i( "Regenerated %d classes (%d dependents), %d files written in %.6f seconds",
+			(i32)changedClasses.size(),
+			(i32)dependents.size(),
+			filesWritten,
+			seconds );
+}
+
+// watchAndRegenerate
+void watchAndRegenerate( vector<shared_ptr<GenConfig>>& configs, const GenStats& stats ) {
+
+	// the stats of every class as of its last generation, for the depfile and manifest
+	GenStats outputs = stats;
+
+
+	i32 inotifyFd = inotify_init1( IN_CLOEXEC );
+	if ( inotifyFd < 0 ) {
+		throw CRException( "Error(%d) while initializing inotify: %s", errno, strerror( errno ));
+	}
+
+	// watch the directories rather than the files themselves: editors often save by replacing the file
+	map<i32, map<string, size_t>> watchedFiles; // watch descriptor -> file name -> config index
+	for ( size_t i = 0; i < configs.size(); i++ ) {
+
+		const string& path = configs[i]->_inputFile.getFullPath();
+		size_t lastSeparator = path.find_last_of( PATH_SEPARATOR );
+		string dir = (lastSeparator == string::npos) ? "." : path.substr( 0, lastSeparator + 1 );
+		string fileName = (lastSeparator == string::npos) ? path : path.substr( lastSeparator + 1 );
+
+		i32 wd = inotify_add_watch( inotifyFd, dir.c_str(), WATCH_EVENT_MASK );
+		if ( wd < 0 ) {
+			close( inotifyFd );
+			throw CRException( "Error(%d) while trying to watch %s: %s", errno, dir.c_str(), strerror( errno ));
+		}
+
+		watchedFiles[wd][fileName] = i;
+	}
+
+	Log::i( "Watching %d input files for changes", (i32)configs.size() );
+
+	char buffer[sizeof( struct inotify_event ) * 64 + 4096] __attribute__(( aligned( __alignof__( struct inotify_event ))));
+	set<size_t> changedConfigs;
+
+	while ( true ) {
+
+		// block until something happens, then keep collecting until things settle down
+		struct pollfd pfd = { inotifyFd, POLLIN, 0 };
+		i32 timeout = changedConfigs.empty() ? -1 : WATCH_SETTLE_MILLIS;
+		i32 ready = poll( &pfd, 1, timeout );
+
+		if ( ready < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			close( inotifyFd );
+			throw CRException( "Error(%d) while waiting for inotify events: %s", errno, strerror( errno ));
+		}
+
+		if ( ready == 0 ) {
+			regenerate( configs, changedConfigs, outputs );
+			changedConfigs.clear();
+			continue;
+		}
+
+		ssize_t length = read( inotifyFd, buffer, sizeof( buffer ));
+		if ( length <= 0 ) {
+			continue;
+		}
+
+		for ( char* ptr = buffer; ptr < buffer + length; ) {
+
+			const struct inotify_event* event = (const struct inotify_event*)ptr;
+			ptr += sizeof( struct inotify_event ) + event->len;
+
+			if ( event->len == 0 ) {
+				continue;
+			}
+
+			auto dirItr = watchedFiles.find( event->wd );
+			if ( dirItr == watchedFiles.end() ) {
+				continue;
+			}
+
+			auto fileItr = dirItr->second.find( event->name );
+			if ( fileItr != dirItr->second.end() ) {
+				changedConfigs.insert( fileItr->second );
+			}
+		}
+	}
+}
+
+}
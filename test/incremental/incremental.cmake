@@ -0,0 +1,56 @@
+# Generates a copy of schema.cr.xml repeatedly into the same output dir, checking that only the
+# classes whose output would change are regenerated: none when nothing changed, the edited class
+# after an edit, a class whose output file was deleted, and all of them after coderoller changed.
+#
+# usage: cmake -DCODEROLLER=... -DSOURCE_DIR=... -DOUTPUT_DIR=... -P incremental.cmake
+
+file(REMOVE_RECURSE "${OUTPUT_DIR}")
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+set(INPUT "${OUTPUT_DIR}/schema.cr.xml")
+configure_file("${SOURCE_DIR}/schema.cr.xml" "${INPUT}" COPYONLY)
+
+# generate the input, checking that the expected number of classes was skipped
+function(generate expectedSkipped)
+	if(NOT DEFINED generator)
+		set(generator "${CODEROLLER}")
+	endif()
+	execute_process(
+		COMMAND "${generator}" --deterministic --no-cache --stats=json "${INPUT}" "${OUTPUT_DIR}/out/"
+		RESULT_VARIABLE result
+		OUTPUT_VARIABLE stats
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "coderoller failed")
+	endif()
+	if(NOT stats MATCHES "\"classesSkipped\": ${expectedSkipped},")
+		message(FATAL_ERROR "expected ${expectedSkipped} classes to be skipped:\n${stats}")
+	endif()
+endfunction()
+
+generate(0)
+generate(2)
+
+# an edited class is regenerated, and the other one isn't
+file(READ "${INPUT}" schema)
+string(REPLACE "type=\"i32\"" "type=\"i64\"" schema "${schema}")
+file(WRITE "${INPUT}" "${schema}")
+generate(1)
+file(READ "${OUTPUT_DIR}/out/include/Alpha.gen.h" header)
+if(NOT header MATCHES "int64_t _a;")
+	message(FATAL_ERROR "Alpha.gen.h wasn't regenerated after its field changed")
+endif()
+
+# a class whose output is missing is regenerated, even though it is up to date
+file(REMOVE "${OUTPUT_DIR}/out/include/Beta.gen.h")
+generate(1)
+if(NOT EXISTS "${OUTPUT_DIR}/out/include/Beta.gen.h")
+	message(FATAL_ERROR "Beta.gen.h wasn't regenerated after it was deleted")
+endif()
+
+# a different coderoller executable (here, one with a byte appended, which still runs) regenerates
+# everything, even though its git hash is the same
+set(generator "${OUTPUT_DIR}/coderoller")
+file(COPY "${CODEROLLER}" DESTINATION "${OUTPUT_DIR}")
+file(APPEND "${generator}" " ")
+generate(0)
+generate(2)
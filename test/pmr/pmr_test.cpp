@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <memory_resource>
+#include <vector>
+
+#include "core/types.h"
+
+#include "Part.gen.h"
+#include "Whole.gen.h"
+
+using namespace cr;
+using std::vector;
+
+/**
+ * Serializes the allocator-aware classes of pmr.cr.xml and internalizes them again into objects using
+ * a counting memory resource, with a default resource which can't allocate, so that any string or
+ * object which doesn't allocate from the resource it was given fails the test.
+ */
+
+static i32 s_failures = 0;
+
+// check
+static void check( bool condition, const char* what ) {
+	if ( ! condition ) {
+		fprintf( stderr, "FAILED: %s\n", what );
+		s_failures++;
+	}
+}
+
+/**
+ * A memory resource which counts the allocations it passes on to new and delete
+ */
+class CountingResource : public std::pmr::memory_resource {
+
+public:
+
+	i64 _allocations = 0;
+
+private:
+
+	void* do_allocate( size_t bytes, size_t alignment ) override {
+		_allocations++;
+		return std::pmr::new_delete_resource()->allocate( bytes, alignment );
+	}
+
+	void do_deallocate( void* pointer, size_t bytes, size_t alignment ) override {
+		std::pmr::new_delete_resource()->deallocate( pointer, bytes, alignment );
+	}
+
+	bool do_is_equal( const std::pmr::memory_resource& other ) const noexcept override {
+		return this == &other;
+	}
+};
+
+// makeWhole
+static void makeWhole( Whole& o, i32 i ) {
+	o.setId( 100 + i );
+	o.setName( "a name too long for the small string buffer" );
+	o.getPart().setX( -i );
+	o.getPart().setOk( i % 2 == 1 );
+	o.getPart().setS( "another string which is also long" );
+	o.getPart().setTag( "tag" );
+	o.setNote( "and a note long enough to allocate" );
+	o.setH( (i8)i );
+}
+
+// isWhole
+static bool isWhole( const Whole& o, i32 i ) {
+	return o.getId() == (ui64)(100 + i)
+			&& o.getName() == "a name too long for the small string buffer"
+			&& o.getPart().getX() == -i
+			&& o.getPart().getOk() == (i % 2 == 1)
+			&& o.getPart().getS() == "another string which is also long"
+			&& o.getPart().getTag() == "tag"
+			&& o.getNote() == "and a note long enough to allocate"
+			&& o.getH() == (i8)i;
+}
+
+// usesResource
+static bool usesResource( const Whole& o, std::pmr::memory_resource* resource ) {
+	return o.getName().get_allocator().resource() == resource
+			&& o.getPart().getS().get_allocator().resource() == resource
+			&& o.getNote().get_allocator().resource() == resource;
+}
+
+// testObject
+static void testObject() {
+
+	CountingResource resource;
+	Whole o( &resource );
+	makeWhole( o, 1 );
+	check( usesResource( o, &resource ) && resource._allocations > 0, "Whole allocates from its resource" );
+
+	vector<char> data( o.getSerializedSize() );
+	i64 size = (i64)data.size();
+	check( o.serialize( data.data() ) == size, "Whole serialize writes its serialized size" );
+
+	Whole unchecked( &resource );
+	check( unchecked.internalize( (void*)data.data() ) == size, "Whole internalize reads its serialized size" );
+	check( isWhole( unchecked, 1 ) && usesResource( unchecked, &resource ), "Whole internalize round trips" );
+
+	Whole checked( &resource );
+	check( checked.internalize( (const void*)data.data(), size ) == size, "Whole checked internalize reads its serialized size" );
+	check( isWhole( checked, 1 ) && usesResource( checked, &resource ), "Whole checked internalize round trips" );
+
+	for ( i64 n = 0; n < size; n++ ) {
+		vector<char> prefix( data.begin(), data.begin() + n );
+		Whole truncated( &resource );
+		check( truncated.internalize( (const void*)prefix.data(), n ) == -1, "Whole checked internalize rejects a truncated buffer" );
+	}
+
+	// copying into another resource keeps to that resource
+	CountingResource other;
+	Whole copy( o, &other );
+	check( isWhole( copy, 1 ) && usesResource( copy, &other ), "Whole allocator-extended copy uses its own resource" );
+}
+
+// testColumns
+static void testColumns() {
+
+	CountingResource resource;
+	WholeColumns columns( &resource );
+	for ( i32 i = 0; i < 3; i++ ) {
+		Whole o( &resource );
+		makeWhole( o, i );
+		columns.push_back( std::move( o ));
+	}
+
+	vector<char> data( columns.getSerializedSize() );
+	i64 size = (i64)data.size();
+	check( columns.serialize( data.data() ) == size, "WholeColumns serialize writes its serialized size" );
+
+	WholeColumns checked( &resource );
+	check( checked.internalize( (const void*)data.data(), size ) == size, "WholeColumns checked internalize reads its serialized size" );
+	check( checked.size() == 3, "WholeColumns checked internalize reads every row" );
+	for ( size_t i = 0; i < checked.size(); i++ ) {
+		check( checked[i].getName().get_allocator().resource() == &resource, "WholeColumns rows allocate from its resource" );
+	}
+
+	// a std::pmr::vector passes its resource on to its elements
+	std::pmr::vector<Whole> objects( &resource );
+	objects.resize( 1 );
+	check( objects[0].internalize( (const void*)( data.data() + sizeof( i64 )), size - (i64)sizeof( i64 )) > 0, "Whole internalizes a row of WholeColumns" );
+	check( isWhole( objects[0], 0 ) && usesResource( objects[0], &resource ), "std::pmr::vector<Whole> elements allocate from its resource" );
+}
+
+// main
+i32 main() {
+
+	// anything allocating from the default resource instead of the one it was given throws
+	std::pmr::set_default_resource( std::pmr::null_memory_resource() );
+
+	try {
+		testObject();
+		testColumns();
+	} catch ( const std::bad_alloc& ) {
+		fprintf( stderr, "FAILED: allocated from the default memory resource\n" );
+		s_failures++;
+	}
+
+	if ( s_failures > 0 ) {
+		fprintf( stderr, "%d checks failed\n", s_failures );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <string.h>
+#include <type_traits>
+#include <vector>
+
+#include "core/types.h"
+
+#include "base/stream_roller.h"
+
+#include "Inner.gen.h"
+#include "Fixed.gen.h"
+#include "Outer.gen.h"
+#include "Sample.gen.h"
+#include "Pooled.gen.h"
+#include "Inlined.gen.h"
+#include "Plain.gen.h"
+
+using namespace cr;
+using std::vector;
+
+/**
+ * Serializes the classes of roundtrip.cr.xml and internalizes them again, both unchecked and bounds
+ * checked, and checks that the bounds checked internalize rejects every truncation of the input
+ * (which, copied to a buffer of exactly its size, a sanitizer build would also catch reading past).
+ */
+
+static i32 s_failures = 0;
+
+// check
+static void check( bool condition, const char* what ) {
+	if ( ! condition ) {
+		fprintf( stderr, "FAILED: %s\n", what );
+		s_failures++;
+	}
+}
+
+// makeOuter
+static Outer makeOuter() {
+	Outer o;
+	o.setId( 7 );
+	o.setName( "hello" );
+	o.getIn().setX( -300 );
+	o.getIn().setP( true );
+	o.getIn().setS( "abcdef" );
+	o.getFx().setA( 1.5f );
+	o.getFx().setB( 9 );
+	o.setN( 1ll << 40 );
+	o.setTail( -2 );
+	o.setNote( "zz" );
+	o.setH( 3 );
+	return o;
+}
+
+// isOuter
+static bool isOuter( const Outer& o ) {
+	return o.getId() == 7
+			&& o.getName() == "hello"
+			&& o.getIn().getX() == -300
+			&& o.getIn().getP()
+			&& o.getIn().getS() == "abcdef"
+			&& o.getFx().getA() == 1.5f
+			&& o.getFx().getB() == 9
+			&& o.getN() == (1ll << 40)
+			&& o.getTail() == -2
+			&& o.getNote() == "zz"
+			&& o.getH() == 3;
+}
+
+/**
+ * Returns the serialized form of the given object
+ */
+template <typename TYPE>
+static vector<char> serializeToVector( const TYPE& object ) {
+	vector<char> data( object.getSerializedSize() );
+	object.serialize( data.data() );
+	return data;
+}
+
+/**
+ * Returns the result of internalizing the first size bytes of data into object, from a buffer
+ * holding only those bytes
+ */
+template <typename TYPE>
+static i64 internalizePrefix( TYPE& object, const vector<char>& data, i64 size ) {
+	vector<char> prefix( data.begin(), data.begin() + size );
+	return object.internalize( (const void*)prefix.data(), size );
+}
+
+// testObject
+static void testObject() {
+
+	Outer o = makeOuter();
+	i64 size = o.getSerializedSize();
+	vector<char> data( size );
+	check( o.serialize( data.data() ) == size, "Outer serialize writes its serialized size" );
+
+	Outer unchecked;
+	check( unchecked.internalize( (void*)data.data() ) == size, "Outer internalize reads its serialized size" );
+	check( isOuter( unchecked ), "Outer internalize round trips" );
+
+	Outer checked;
+	check( checked.internalize( (const void*)data.data(), size ) == size, "Outer checked internalize reads its serialized size" );
+	check( isOuter( checked ), "Outer checked internalize round trips" );
+
+	for ( i64 n = 0; n < size; n++ ) {
+		Outer truncated;
+		check( internalizePrefix( truncated, data, n ) == -1, "Outer checked internalize rejects a truncated buffer" );
+	}
+
+	// a huge or negative string length (of name, following the fixed size id) is rejected
+	vector<char> bad( data );
+	LittleEndian::write( bad.data() + sizeof( ui64 ), (i64)0x7fffffffffffff00ll );
+	check( checked.internalize( (const void*)bad.data(), size ) == -1, "Outer checked internalize rejects a huge length" );
+	LittleEndian::write( bad.data() + sizeof( ui64 ), (i64)-5 );
+	check( checked.internalize( (const void*)bad.data(), size ) == -1, "Outer checked internalize rejects a negative length" );
+
+	// a varint that never ends
+	vector<char> endless( Varint::MAX_SIZE * 2, (char)0xff );
+	Inner in;
+	check( in.internalize( (const void*)endless.data(), (i64)endless.size() ) == -1, "Inner checked internalize rejects an endless varint" );
+}
+
+// testColumns
+static void testColumns() {
+
+	SampleColumns columns;
+	for ( i32 i = 0; i < 3; i++ ) {
+		Sample s;
+		s.setTs( -1000 * i );
+		s.setOk( i % 2 == 0 );
+		s.setLabel( string( i, 'x' ));
+		s.getFx().setB( (ui16)i );
+		s.setV( i * 0.5 );
+		if ( i == 1 ) {
+			s.setNote( "cold" );
+		}
+
+		// moved rows, with and without their cold fields allocated, as well as a copied one
+		if ( i < 2 ) {
+			columns.push_back( std::move( s ));
+		} else {
+			columns.push_back( s );
+		}
+	}
+
+	i64 size = columns.getSerializedSize();
+	vector<char> data( size );
+	check( columns.serialize( data.data() ) == size, "SampleColumns serialize writes its serialized size" );
+
+	SampleColumns checked;
+	check( checked.internalize( (const void*)data.data(), size ) == size, "SampleColumns checked internalize reads its serialized size" );
+	check( checked.size() == 3, "SampleColumns checked internalize reads every row" );
+	for ( size_t i = 0; i < checked.size(); i++ ) {
+		Sample s = checked.get( i );
+		check( s.getTs() == -1000 * (i64)i
+				&& s.getOk() == (i % 2 == 0)
+				&& s.getLabel() == string( i, 'x' )
+				&& s.getFx().getB() == i
+				&& s.getV() == i * 0.5
+				&& s.getNote() == (i == 1 ? "cold" : ""), "SampleColumns checked internalize round trips" );
+	}
+
+	for ( i64 n = 0; n < size; n++ ) {
+		SampleColumns truncated;
+		check( internalizePrefix( truncated, data, n ) == -1, "SampleColumns checked internalize rejects a truncated buffer" );
+	}
+
+	// a row count the buffer can't hold is rejected before the columns are sized for it
+	vector<char> bad( data );
+	LittleEndian::write( bad.data(), (i64)1 << 60 );
+	check( checked.internalize( (const void*)bad.data(), size ) == -1, "SampleColumns checked internalize rejects a huge count" );
+}
+
+// testStream
+static void testStream() {
+
+	vector<Outer> objects;
+	objects.push_back( makeOuter() );
+	objects.push_back( makeOuter() );
+
+	pair<i64, unique_ptr<ui8[]>> stream = createStreamContents( objects );
+	vector<char> data( (char*)stream.second.get(), (char*)stream.second.get() + stream.first );
+
+	vector<pair<i32, i64>> contents;
+	check( listStreamContents( (const void*)data.data(), stream.first, contents ) == stream.first, "listStreamContents reads the whole stream" );
+	check( contents.size() == 2, "listStreamContents lists every object" );
+
+	for ( i64 i = 0; i < (i64)contents.size(); i++ ) {
+		Outer o;
+		check( getObject( contents, (const void*)data.data(), stream.first, i, o ) == o.getSerializedSize(), "getObject reads the object" );
+		check( isOuter( o ), "getObject round trips" );
+	}
+
+	Outer o;
+	check( getObject( contents, (const void*)data.data(), stream.first, (i64)contents.size(), o ) == -1, "getObject rejects an index out of bounds" );
+
+	for ( i64 n = 0; n < stream.first; n++ ) {
+		vector<char> prefix( data.begin(), data.begin() + n );
+		vector<pair<i32, i64>> truncated;
+		check( listStreamContents( (const void*)prefix.data(), n, truncated ) == -1 && truncated.empty(), "listStreamContents rejects a truncated stream" );
+	}
+
+	// an object whose recorded size is cut short can't be read past it
+	vector<char> bad( data );
+	LittleEndian::write( bad.data() + contents[0].second - sizeof( i32 ) - sizeof( i64 ), makeOuter().getSerializedSize() - 1 );
+	check( getObject( contents, (const void*)bad.data(), stream.first, 0, o ) == -1, "getObject rejects an object longer than its recorded size" );
+}
+
+// testStaticStream
+static void testStaticStream() {
+
+	static_assert( ! std::is_polymorphic<Plain>::value, "Plain has no vtable" );
+	static_assert( std::is_trivially_copyable<Plain>::value, "Plain is trivially copyable" );
+
+	vector<Plain> objects( 3 );
+	for ( i32 i = 0; i < (i32)objects.size(); i++ ) {
+		objects[i].setId( 1000 + i );
+		objects[i].setX( -70 * i );
+		objects[i].setV( i * 0.25 );
+		objects[i].setOk( i == 1 );
+	}
+
+	pair<i64, unique_ptr<ui8[]>> stream = createStreamContents( objects );
+	vector<char> data( (char*)stream.second.get(), (char*)stream.second.get() + stream.first );
+
+	vector<pair<i32, i64>> contents;
+	check( listStreamContents( (const void*)data.data(), stream.first, contents ) == stream.first, "listStreamContents reads the whole stream of Plain" );
+	check( contents.size() == objects.size(), "listStreamContents lists every Plain" );
+
+	for ( i64 i = 0; i < (i64)contents.size(); i++ ) {
+		Plain o;
+		check( getObject( contents, (const void*)data.data(), stream.first, i, o ) == getObjectSerializedSize( o ), "getObject reads the Plain" );
+		check( o.getId() == objects[i].getId()
+				&& o.getX() == objects[i].getX()
+				&& o.getV() == objects[i].getV()
+				&& o.getOk() == objects[i].getOk(), "getObject round trips Plain" );
+	}
+
+	for ( i64 n = 0; n < stream.first; n++ ) {
+		vector<char> prefix( data.begin(), data.begin() + n );
+		vector<pair<i32, i64>> truncated;
+		check( listStreamContents( (const void*)prefix.data(), n, truncated ) == -1, "listStreamContents rejects a truncated stream of Plain" );
+	}
+
+	// the statically dispatched calls on a single object
+	vector<char> single( getObjectSerializedSize( objects[2] ));
+	check( serializeObject( objects[2], single.data() ) == (i64)single.size(), "serializeObject writes the Plain's serialized size" );
+	Plain o;
+	check( internalizeObject( o, (const void*)single.data(), (i64)single.size() ) == (i64)single.size() && o.getX() == -140, "internalizeObject round trips Plain" );
+}
+
+// testInline
+static void testInline() {
+
+	Inlined o;
+	o.setId( 300 );
+	o.setOk( true );
+	o.getIn().setX( 4 );
+	o.getIn().setS( "abc" );
+	o.setLabel( "inline" );
+	o.setNote( "cold" );
+
+	vector<char> data = serializeToVector( o );
+	i64 size = (i64)data.size();
+	Inlined checked;
+	check( checked.internalize( (const void*)data.data(), size ) == size, "Inlined checked internalize reads its serialized size" );
+	check( checked.getId() == 300
+			&& checked.getOk()
+			&& checked.getIn().getX() == 4
+			&& checked.getIn().getS() == "abc"
+			&& checked.getLabel() == "inline"
+			&& checked.getNote() == "cold", "Inlined checked internalize round trips" );
+
+	for ( i64 n = 0; n < size; n++ ) {
+		Inlined truncated;
+		check( internalizePrefix( truncated, data, n ) == -1, "Inlined checked internalize rejects a truncated buffer" );
+	}
+
+	// the inline copy and move operations keep the cold fields
+	Inlined copy;
+	copy.copyFrom( checked );
+	check( serializeToVector( copy ) == data, "Inlined copyFrom copies every field" );
+	Inlined moved( std::move( copy ));
+	check( serializeToVector( moved ) == data, "Inlined move keeps every field" );
+}
+
+// testPool
+static void testPool() {
+
+	// leave the heap dirty where a fresh object is likely to be allocated, so that fields left
+	// uninitialized by acquire() show up
+	Pooled* dirty = new Pooled();
+	dirty->setId( -1 );
+	dirty->setF( -1.0f );
+	dirty->setOk( true );
+	delete dirty;
+
+	Pooled::Pool::clear();
+	Pooled* fresh = Pooled::Pool::acquire();
+	check( fresh->getId() == 0 && fresh->getF() == 0.0f && ! fresh->getOk() && fresh->getName().empty(), "Pool acquire gives a fresh object default values" );
+	vector<char> freshData = serializeToVector( *fresh );
+
+	// a released object is reset, keeping nothing of its values
+	fresh->setId( 5 );
+	fresh->setOk( true );
+	fresh->setName( "used" );
+	fresh->setNote( "cold" );
+	fresh->setCount( 3 );
+	Pooled::Pool::release( fresh );
+	check( Pooled::Pool::size() == 1, "Pool release keeps the object" );
+
+	Pooled* recycled = Pooled::Pool::acquire();
+	check( recycled == fresh, "Pool acquire recycles a released object" );
+	check( serializeToVector( *recycled ) == freshData, "Pool acquire gives equal fresh and recycled objects" );
+
+	// a handle releases its object when it goes away
+	{
+		Pooled::Pool::Handle handle( recycled );
+		handle->setId( 9 );
+	}
+	check( Pooled::Pool::size() == 1, "Pool handle releases its object" );
+	Pooled::Pool::Handle handle = Pooled::Pool::acquireHandle();
+	check( handle->getId() == 0, "Pool handle acquires a reset object" );
+}
+
+// main
+i32 main() {
+
+	testObject();
+	testColumns();
+	testStream();
+	testStaticStream();
+	testInline();
+	testPool();
+
+	if ( s_failures > 0 ) {
+		fprintf( stderr, "%d checks failed\n", s_failures );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,85 @@
+# Generates a copy of schema.cr.xml through the schema cache (once to fill it, then from it), and
+# checks that the output is the same as when the input is parsed. The cache must also be missed
+# after the input is edited or coderoller changed, and a damaged cache file ignored.
+#
+# usage: cmake -DCODEROLLER=... -DSOURCE_DIR=... -DOUTPUT_DIR=... -P schema_cache.cmake
+
+file(REMOVE_RECURSE "${OUTPUT_DIR}")
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+set(INPUT "${OUTPUT_DIR}/schema.cr.xml")
+configure_file("${SOURCE_DIR}/schema.cr.xml" "${INPUT}" COPYONLY)
+
+# generate the input into the given dir (under OUTPUT_DIR), with the given extra options, checking
+# whether it was loaded from the schema cache (expectLoaded is TRUE or FALSE)
+function(generate dir expectLoaded)
+	if(NOT DEFINED generator)
+		set(generator "${CODEROLLER}")
+	endif()
+	execute_process(
+		COMMAND "${generator}" --deterministic ${ARGN} "${INPUT}" "${OUTPUT_DIR}/${dir}/"
+		RESULT_VARIABLE result
+		OUTPUT_VARIABLE log
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "coderoller failed generating ${dir}")
+	endif()
+	if(log MATCHES "from the schema cache")
+		set(loaded TRUE)
+	else()
+		set(loaded FALSE)
+	endif()
+	if(NOT loaded STREQUAL expectLoaded)
+		message(FATAL_ERROR "generating ${dir}: expected loaded from the schema cache to be ${expectLoaded}:\n${log}")
+	endif()
+endfunction()
+
+# check that every generated file of the cached dir matches the parsed one
+function(compare cached parsed)
+	foreach(file include/Gamma.gen.h include/Delta.gen.h src/Gamma.gen.cpp src/Delta.gen.cpp)
+		file(READ "${OUTPUT_DIR}/${cached}/${file}" cachedSource)
+		file(READ "${OUTPUT_DIR}/${parsed}/${file}" parsedSource)
+		if(NOT cachedSource STREQUAL parsedSource)
+			message(FATAL_ERROR "${cached}/${file} differs from ${parsed}/${file}")
+		endif()
+	endforeach()
+endfunction()
+
+# the first run fills the cache, the second (into another dir, so nothing is skipped) loads from it
+generate(fill FALSE)
+file(GLOB caches "${OUTPUT_DIR}/fill/.coderoller.cache/*.bin")
+if(NOT caches)
+	message(FATAL_ERROR "no schema cache was written")
+endif()
+file(COPY "${OUTPUT_DIR}/fill/.coderoller.cache" DESTINATION "${OUTPUT_DIR}/cached")
+generate(cached TRUE)
+generate(parsed FALSE --no-cache)
+compare(cached parsed)
+
+# an edited input misses the cache
+file(READ "${INPUT}" schema)
+string(REPLACE "type=\"f64\"" "type=\"f32\"" schema "${schema}")
+file(WRITE "${INPUT}" "${schema}")
+generate(cached FALSE)
+file(READ "${OUTPUT_DIR}/cached/include/Delta.gen.h" header)
+if(NOT header MATCHES "float _v")
+	message(FATAL_ERROR "Delta.gen.h was generated from a stale schema cache")
+endif()
+
+# a damaged cache is ignored
+file(GLOB caches "${OUTPUT_DIR}/cached/.coderoller.cache/*.bin")
+foreach(cache ${caches})
+	file(WRITE "${cache}" "damaged")
+endforeach()
+file(REMOVE_RECURSE "${OUTPUT_DIR}/cached/include" "${OUTPUT_DIR}/cached/src" "${OUTPUT_DIR}/parsed")
+generate(cached FALSE)
+generate(parsed FALSE --no-cache)
+compare(cached parsed)
+
+# the rewritten cache is loaded, but not by a different coderoller executable (here, one with a byte
+# appended, which still runs)
+generate(cached TRUE)
+set(generator "${OUTPUT_DIR}/coderoller")
+file(COPY "${CODEROLLER}" DESTINATION "${OUTPUT_DIR}")
+file(APPEND "${generator}" " ")
+generate(cached FALSE)
+generate(cached TRUE)
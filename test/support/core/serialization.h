@@ -0,0 +1,11 @@
+#ifndef __CR_TEST_SERIALIZATION_H_
+#define __CR_TEST_SERIALIZATION_H_
+
+/**
+ * Generated serializable classes include core/serialization.h, whose Serialization reads and writes
+ * ByteArray blobs. The test schemas have none, so this stands in for it.
+ */
+
+#include "core/types.h"
+
+#endif
@@ -0,0 +1,44 @@
+# Generates before.cr.xml without --unity, then into one unity source, which must delete the per class
+# sources, and then after.cr.xml, which removes a class, into the same output dir. Alpha is up to
+# date the last time, but the unity source must still be regenerated without Beta.
+#
+# usage: cmake -DCODEROLLER=... -DSOURCE_DIR=... -DOUTPUT_DIR=... -P unity_removal.cmake
+
+file(REMOVE_RECURSE "${OUTPUT_DIR}")
+set(UNITY_SOURCE "${OUTPUT_DIR}/src/unity_0.gen.cpp")
+
+function(generate input unity)
+	execute_process(
+		COMMAND "${CODEROLLER}" --deterministic --no-cache ${unity} "${SOURCE_DIR}/${input}" "${OUTPUT_DIR}/"
+		RESULT_VARIABLE result
+		OUTPUT_QUIET
+	)
+	if(NOT result EQUAL 0)
+		message(FATAL_ERROR "coderoller failed on ${input}")
+	endif()
+endfunction()
+
+generate(before.cr.xml "")
+if(NOT EXISTS "${OUTPUT_DIR}/src/Alpha.gen.cpp")
+	message(FATAL_ERROR "Alpha.gen.cpp is missing after generating before.cr.xml without --unity")
+endif()
+
+generate(before.cr.xml --unity=1)
+foreach(name Alpha Beta)
+	if(EXISTS "${OUTPUT_DIR}/src/${name}.gen.cpp")
+		message(FATAL_ERROR "${name}.gen.cpp is still there after switching to --unity")
+	endif()
+endforeach()
+file(READ "${UNITY_SOURCE}" source)
+if(NOT source MATCHES "Beta::")
+	message(FATAL_ERROR "${UNITY_SOURCE} is missing Beta after generating before.cr.xml")
+endif()
+
+generate(after.cr.xml --unity=1)
+file(READ "${UNITY_SOURCE}" source)
+if(source MATCHES "Beta")
+	message(FATAL_ERROR "${UNITY_SOURCE} still holds Beta after it was removed")
+endif()
+if(NOT source MATCHES "Alpha::")
+	message(FATAL_ERROR "${UNITY_SOURCE} is missing Alpha after generating after.cr.xml")
+endif()